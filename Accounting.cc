@@ -0,0 +1,192 @@
+#include <string.h>
+
+#include "Accounting.h"
+
+//---------------------------------------------------------------------------------------------
+// Accounting class implementation (response and blocking times per task and job).
+//---------------------------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------------------
+	// Constructor
+	//-----------------------------------------------------------------------------------------
+	Accounting::Accounting(int maxTaskId)
+	{
+		tasks.resize(maxTaskId + 1);
+		jobs.resize(maxTaskId + 1);
+		priorities.resize(maxTaskId + 1, 0);
+		memset(&tasks[0], 0, tasks.size() * sizeof(TaskAccount));
+		lastRunning = NO_TASK;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Starts accounting a job.
+	//-----------------------------------------------------------------------------------------
+	void Accounting::released(TaskSpec* task, int time)
+	{
+		JobAccount &job = jobs[task->id];
+		job.release = time;
+		job.direct = 0;
+		job.pushThrough = 0;
+		job.blocking = NOT_BLOCKED;
+		job.blocked = false;
+		job.started = false;
+		job.active = true;
+
+		std::vector<int> &level = active[task->priority];
+		job.position = level.size();
+		priorities[task->id] = task->priority;
+		level.push_back(task->id);
+		tasks[task->id].jobs++;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Adds the job to its task's totals and maxima.
+	//-----------------------------------------------------------------------------------------
+	void Accounting::completed(TaskSpec* task, int time)
+	{
+		JobAccount &job = jobs[task->id];
+		TaskAccount &account = tasks[task->id];
+
+		int response = time - job.release;
+		account.completed++;
+		account.response += response;
+		if (response > account.maxResponse)
+			account.maxResponse = response;
+		if (job.direct > account.maxDirect)
+			account.maxDirect = job.direct;
+		if (job.pushThrough > account.maxPushThrough)
+			account.maxPushThrough = job.pushThrough;
+		job.active = false;
+
+		// remove from the active list of its level (last entry takes its place)
+		std::vector<int> &level = active[priorities[task->id]];
+		int last = level.back();
+		level[job.position] = last;
+		jobs[last].position = job.position;
+		level.pop_back();
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Finds every active job that a lower priority task keeps from running: the jobs of the
+	// levels above the dispatched task's base priority, or the suspended jobs if idle.
+	// O(levels + blocked jobs), O(active jobs) if idle.
+	//-----------------------------------------------------------------------------------------
+	void Accounting::dispatched(int runningTask, ReadyQueue* queue)
+	{
+		if (runningTask != NO_TASK && runningTask != lastRunning)
+		{
+			tasks[runningTask].switches++;
+			lastRunning = runningTask;
+		}
+
+		for (size_t i = 0; i < blocking.size(); i++)
+			jobs[blocking[i]].blocking = NOT_BLOCKED;
+		blocking.clear();
+
+		int lowest = 0;
+		if (runningTask != NO_TASK)
+		{
+			jobs[runningTask].started = true;
+			lowest = priorities[runningTask] + 1;
+		}
+
+		for (int priority = lowest; priority < PRIORITY_LEVELS; priority++)
+		{
+			for (size_t i = 0; i < active[priority].size(); i++)
+			{
+				int id = active[priority][i];
+				JobAccount &job = jobs[id];
+				bool suspended = queue->isSuspended(id);
+				if (runningTask == NO_TASK && !suspended)
+					continue;
+
+				job.blocking = (suspended && job.started) ? DIRECT_BLOCKING : PUSH_THROUGH_BLOCKING;
+				blocking.push_back(id);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Charges the dispatch to the jobs it blocks. Dispatches without time (the dispatched
+	// task blocked at once) neither start nor end an inversion. O(blocked jobs).
+	//-----------------------------------------------------------------------------------------
+	void Accounting::elapsed(int ticks)
+	{
+		if (ticks == 0)
+			return;
+
+		// inversions of the jobs no longer blocked end
+		for (size_t i = 0; i < blocked.size(); i++)
+		{
+			if (jobs[blocked[i]].blocking == NOT_BLOCKED)
+				jobs[blocked[i]].blocked = false;
+		}
+		blocked = blocking;
+
+		for (size_t i = 0; i < blocking.size(); i++)
+		{
+			int id = blocking[i];
+			JobAccount &job = jobs[id];
+
+			if (job.blocking == DIRECT_BLOCKING)
+			{
+				job.direct += ticks;
+				tasks[id].direct += ticks;
+			}
+			else
+			{
+				job.pushThrough += ticks;
+				tasks[id].pushThrough += ticks;
+			}
+
+			if (!job.blocked)
+			{
+				job.blocked = true;
+				tasks[id].inversions++;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns task totals.
+	//-----------------------------------------------------------------------------------------
+	TaskAccount* Accounting::getTask(int taskId)
+	{
+		return &tasks[taskId];
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Prints one line per task. Jobs still active at the end count in the totals and in the
+	// blocking maxima (blocked so far), but not in the response times.
+	//-----------------------------------------------------------------------------------------
+	void Accounting::print(FILE* file, TaskSet* taskSet)
+	{
+		fprintf(file, "\ntask accounting (ticks, max = worst job)\n");
+		fprintf(file, "%-6s %4s %5s %5s %9s %9s %7s %7s %7s %7s %10s %8s\n", "task", "prio", "jobs", "done",
+				"resp avg", "resp max", "direct", "max", "push", "max", "inversions", "switches");
+
+		int switches = 0;
+
+		for (int i = 0; i < taskSet->getTaskCount(); i++)
+		{
+			TaskSpec *task = taskSet->getTask(i);
+			TaskAccount &account = tasks[task->id];
+			double average = (account.completed > 0) ? (double) account.response / account.completed : 0;
+
+			JobAccount &job = jobs[task->id];
+			int maxDirect = account.maxDirect;
+			int maxPushThrough = account.maxPushThrough;
+			if (job.active && job.direct > maxDirect)
+				maxDirect = job.direct;
+			if (job.active && job.pushThrough > maxPushThrough)
+				maxPushThrough = job.pushThrough;
+
+			fprintf(file, "P%-5d %4d %5d %5d %9.1f %9d %7ld %7d %7ld %7d %10d %8d\n", task->id, task->priority,
+					account.jobs, account.completed, average, account.maxResponse, account.direct,
+					maxDirect, account.pushThrough, maxPushThrough, account.inversions,
+					account.switches);
+			switches += account.switches;
+		}
+
+		fprintf(file, "context switches: %d\n", switches);
+	}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <vector>
+
+#include "ReadyQueue.h"
+#include "TaskSet.h"
+
+#ifndef Accounting_h
+#define Accounting_h
+
+//-----------------------------------------------------------------------------------------
+// Per-task totals and per-job maxima (times in ticks)
+//-----------------------------------------------------------------------------------------
+struct TaskAccount
+{
+	int jobs;				// released jobs
+	int completed;			// completed jobs
+	long response;			// sum of response times (completed jobs)
+	int maxResponse;
+	long direct;			// blocked on a resource while a lower priority task ran
+	int maxDirect;			// worst job
+	long pushThrough;		// ready, but a lower priority task ran (inherited priority)
+	int maxPushThrough;		// worst job
+	int inversions;			// intervals blocked by lower priority tasks
+	int switches;			// dispatches after another task ran (context switches)
+};
+
+//-----------------------------------------------------------------------------------------
+// How a job is blocked by the dispatched task
+//-----------------------------------------------------------------------------------------
+enum Blocking
+{
+	NOT_BLOCKED,
+	DIRECT_BLOCKING,
+	PUSH_THROUGH_BLOCKING
+};
+
+//-----------------------------------------------------------------------------------------
+// Current job of a task
+//-----------------------------------------------------------------------------------------
+struct JobAccount
+{
+	int release;
+	int direct;
+	int pushThrough;
+	Blocking blocking;		// in the current dispatch
+	bool blocked;			// blocked by a lower priority task in the last elapsed dispatch
+	bool started;			// dispatched at least once
+	bool active;			// released, not completed
+	int position;			// index in the active job list of its priority level
+};
+
+//-----------------------------------------------------------------------------------------
+// Accounting class definition.
+// Measures what the resource access protocols are meant to bound. Every dispatch, each
+// released job with a higher base priority than the dispatched task is blocked by it:
+// directly if the job is suspended on a resource, by push-through if it is ready and the
+// dispatched task runs with an inherited priority, or if it is kept from starting (SRP
+// admission, the same ceiling blocking that immediate ceiling causes with a ready job).
+// An idle dispatch blocks every suspended job the same way (e.g. a deadlock). A dispatch
+// lasts one tick, or up to the next event without ticks or when idle in virtual time.
+// A task dispatched after another one counts a context switch.
+// Active jobs are kept per priority level, so a dispatch visits only the levels above the
+// dispatched task and the jobs it blocks, not every active job. Not thread safe (CPU mutex).
+//-----------------------------------------------------------------------------------------
+class Accounting
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		// constructor (task ids 1 .. maxTaskId)
+		Accounting(int maxTaskId);
+
+		// job of task released at time
+		void released(TaskSpec* task, int time);
+
+		// job of task completed at time (end of the tick)
+		void completed(TaskSpec* task, int time);
+
+		// classifies active jobs against the dispatched runningTask (NO_TASK if idle)
+		void dispatched(int runningTask, ReadyQueue* queue);
+
+		// charges ticks of the current dispatch to the jobs it blocks
+		void elapsed(int ticks);
+
+		// returns task totals
+		TaskAccount* getTask(int taskId);
+
+		// prints summary table of all tasks of the task set
+		void print(FILE* file, TaskSet* taskSet);
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		std::vector<TaskAccount> tasks;
+		std::vector<JobAccount> jobs;
+		std::vector<int> priorities;	// base priorities of released tasks
+		std::vector<int> active[PRIORITY_LEVELS];	// tasks with a released, not completed job
+		std::vector<int> blocking;		// jobs blocked by the current dispatch
+		std::vector<int> blocked;		// jobs blocked by the last elapsed dispatch
+		int lastRunning;				// last dispatched task (idle dispatches excluded)
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include <stddef.h>
+#include <vector>
+
+#ifndef CeilingStack_h
+#define CeilingStack_h
+
+//-----------------------------------------------------------------------------------------
+// CeilingStack class template definition and implementation.
+// Locked mutexes of one ceiling protocol in locking order. Every entry also keeps the
+// mutex of the highest ceiling up to it, so the system ceiling is read from the top in
+// O(1). M must provide getCsPriority() (the mutex ceiling).
+// Not thread safe (ceiling stacks are only changed while the CPU mutex is held).
+//-----------------------------------------------------------------------------------------
+template <typename M>
+class CeilingStack
+{
+	//-----------------------------------------------------------------------------------------
+	// Stack entry: locked mutex and the highest ceiling mutex up to this entry
+	//-----------------------------------------------------------------------------------------
+	struct Entry
+	{
+		M *mutex;
+		M *ceilingMutex;
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Returns true if no mutex is locked.
+		//-----------------------------------------------------------------------------------------
+		bool empty()
+		{
+			return entries.empty();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the number of locked mutexes.
+		//-----------------------------------------------------------------------------------------
+		size_t size()
+		{
+			return entries.size();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the locked mutex at index (0 = locked first).
+		//-----------------------------------------------------------------------------------------
+		M* getMutex(size_t index)
+		{
+			return entries[index].mutex;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the mutex holding the system ceiling, NULL if no mutex is locked.
+		//-----------------------------------------------------------------------------------------
+		M* getCeilingMutex()
+		{
+			if (entries.empty())
+				return NULL;
+
+			return entries.back().ceilingMutex;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the system ceiling, 0 if no mutex is locked.
+		//-----------------------------------------------------------------------------------------
+		int getCeiling()
+		{
+			if (entries.empty())
+				return 0;
+
+			return entries.back().ceilingMutex->getCsPriority();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Pushes a locked mutex.
+		//-----------------------------------------------------------------------------------------
+		void push(M* mutex)
+		{
+			Entry entry;
+			entry.mutex = mutex;
+			entry.ceilingMutex = mutex;
+			if (!entries.empty()
+					&& entries.back().ceilingMutex->getCsPriority() >= mutex->getCsPriority())
+				entry.ceilingMutex = entries.back().ceilingMutex;
+
+			entries.push_back(entry);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Pops an unlocked mutex.
+		// Critical sections are normally nested, so this is the top entry. Otherwise the entry
+		// is removed and the ceilings above it are recomputed.
+		//-----------------------------------------------------------------------------------------
+		void pop(M* mutex)
+		{
+			int top = entries.size() - 1;
+			if (top >= 0 && entries[top].mutex == mutex)
+			{
+				entries.pop_back();
+				return;
+			}
+
+			int index = top;
+			while (index >= 0 && entries[index].mutex != mutex)
+				index--;
+			if (index < 0)
+				return;
+
+			entries.erase(entries.begin() + index);
+			for (int i = index; i < (int) entries.size(); i++)
+			{
+				M *locked = entries[i].mutex;
+				entries[i].ceilingMutex = locked;
+				if (i > 0 && entries[i - 1].ceilingMutex->getCsPriority() >= locked->getCsPriority())
+					entries[i].ceilingMutex = entries[i - 1].ceilingMutex;
+			}
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		std::vector<Entry> entries;
+};
+
+#endif
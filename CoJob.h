@@ -0,0 +1,65 @@
+#include <exception>
+
+#ifndef CoJob_h
+#define CoJob_h
+
+// the coroutine engine needs C++20 (g++ -std=c++20), builds without it keep the threads
+#ifdef __cpp_impl_coroutine
+#define COROUTINES_AVAILABLE 1
+
+#include <coroutine>
+
+//-----------------------------------------------------------------------------------------
+// CoJob class definition and implementation.
+// Return type of a job coroutine. The job starts suspended and runs one step each time
+// the scheduler resumes it (on the scheduler's own thread, no locking or context switch).
+// The frame stays alive after the final suspension until destroy() is called.
+//-----------------------------------------------------------------------------------------
+class CoJob
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Coroutine promise (suspends at start and end, no result)
+		//-----------------------------------------------------------------------------------------
+		struct promise_type
+		{
+			CoJob get_return_object()
+			{
+				return CoJob(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		//-----------------------------------------------------------------------------------------
+		// Constructor
+		//-----------------------------------------------------------------------------------------
+		CoJob(std::coroutine_handle<promise_type> handle)
+		{
+			this->handle = handle;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the coroutine handle (owned by the caller).
+		//-----------------------------------------------------------------------------------------
+		std::coroutine_handle<> getHandle()
+		{
+			return handle;
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		std::coroutine_handle<promise_type> handle;
+};
+
+#endif
+
+#endif
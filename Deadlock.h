@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <vector>
+
+#include "ReadyQueue.h"
+#include "Trace.h"
+
+#ifndef Deadlock_h
+#define Deadlock_h
+
+//-----------------------------------------------------------------------------------------
+// Deadlock class definition and implementation.
+// Incremental wait-for graph deadlock detector of the emulated protocol mutexes. A thread
+// that has to wait adds one edge (thread -> mutex -> owner thread), which is kept until
+// the unlock that resumes the thread. Each new edge is checked by following the chain of
+// owners that wait themselves (O(chain length)): reaching the waiting thread again closes
+// a cycle, which is reported in the trace. Only the blocking and resuming paths call the
+// hooks, they return immediately while detection is stopped. Not thread safe (CPU mutex).
+//-----------------------------------------------------------------------------------------
+class Deadlock
+{
+	//-----------------------------------------------------------------------------------------
+	// Wait-for edge of a thread (owner NO_TASK = not waiting)
+	//-----------------------------------------------------------------------------------------
+	struct WaitEdge
+	{
+		int mutexId;
+		int owner;
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Starts detection.
+		//-----------------------------------------------------------------------------------------
+		static void start()
+		{
+			detecting = true;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Stops detection (counted cycles are kept).
+		//-----------------------------------------------------------------------------------------
+		static void stop()
+		{
+			detecting = false;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Thread waits for mutex held by owner: adds the edge and follows the owners. Returns
+		// true if the edge closes a cycle. A chain that runs into an older cycle (not through
+		// threadId) ends after one step per thread at most.
+		//-----------------------------------------------------------------------------------------
+		static bool blocked(int threadId, int mutexId, int owner)
+		{
+			if (!detecting || threadId < 0)
+				return false;
+
+			if (threadId >= (int) edges.size())
+			{
+				WaitEdge none = { 0, NO_TASK };
+				edges.resize(threadId + 1, none);
+			}
+			edges[threadId].mutexId = mutexId;
+			edges[threadId].owner = owner;
+
+			int current = owner;
+			for (size_t steps = 0; current != NO_TASK && current != threadId && steps < edges.size(); steps++)
+				current = waitsFor(current);
+			if (current != threadId)
+				return false;
+
+			// report the cycle from the thread that closed it
+			cycles++;
+			Trace::record(TRACE_DEADLOCK_CYCLE, threadId, mutexId, 0, cycles);
+			current = threadId;
+			do
+			{
+				Trace::record(TRACE_DEADLOCK_EDGE, current, edges[current].mutexId, 0, edges[current].owner);
+				current = edges[current].owner;
+			}
+			while (current != threadId);
+
+			return true;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Thread resumed (retries its lock): removes its edge.
+		//-----------------------------------------------------------------------------------------
+		static void unblocked(int threadId)
+		{
+			if (!detecting || threadId < 0 || threadId >= (int) edges.size())
+				return;
+
+			edges[threadId].owner = NO_TASK;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns number of detected cycles.
+		//-----------------------------------------------------------------------------------------
+		static int getCycles()
+		{
+			return cycles;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Prints number of detected cycles.
+		//-----------------------------------------------------------------------------------------
+		static void dump(FILE* file)
+		{
+			fprintf(file, "deadlocks detected: %d\n", cycles);
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		//-----------------------------------------------------------------------------------------
+		// Returns the thread the thread waits for (NO_TASK if it does not wait).
+		//-----------------------------------------------------------------------------------------
+		static int waitsFor(int threadId)
+		{
+			if (threadId < 0 || threadId >= (int) edges.size())
+				return NO_TASK;
+
+			return edges[threadId].owner;
+		}
+
+		static inline std::vector<WaitEdge> edges;		// by thread id
+		static inline bool detecting = false;
+		static inline int cycles = 0;
+};
+
+#endif
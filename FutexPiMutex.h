@@ -0,0 +1,123 @@
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <atomic>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#ifndef FutexPiMutex_h
+#define FutexPiMutex_h
+
+#ifdef __linux__
+
+//-----------------------------------------------------------------------------------------
+// FutexPiMutex (futex based priority inheritance mutex) class definition and implementation.
+// The lock word holds the owner's kernel thread id (0 = unlocked). Uncontended lock and
+// unlock are a single compare-and-swap in user space. Contended cases go to
+// FUTEX_LOCK_PI/FUTEX_UNLOCK_PI: the kernel queues waiters by priority and boosts the
+// owner, also along chains of PI futexes. Linux only.
+//-----------------------------------------------------------------------------------------
+class FutexPiMutex
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Constructor
+		//-----------------------------------------------------------------------------------------
+		FutexPiMutex()
+		{
+			word.store(0, std::memory_order_relaxed);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Locks mutex, returns 0 (success) or error code (failure).
+		//-----------------------------------------------------------------------------------------
+		int lock()
+		{
+			uint32_t expected = 0;
+			if (word.compare_exchange_strong(expected, getThreadId(), std::memory_order_acquire))
+				return 0;
+
+			// contended: the kernel sets FUTEX_WAITERS, boosts the owner and blocks us
+			while (futex(FUTEX_LOCK_PI_PRIVATE) != 0)
+			{
+				if (errno != EINTR && errno != EAGAIN)
+					return errno;
+			}
+
+			return 0;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Tries to lock mutex, returns 0 (success) or EBUSY (already locked).
+		//-----------------------------------------------------------------------------------------
+		int trylock()
+		{
+			uint32_t expected = 0;
+			if (word.compare_exchange_strong(expected, getThreadId(), std::memory_order_acquire))
+				return 0;
+
+			return EBUSY;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Unlocks mutex, returns 0 (success) or error code (failure, e.g. EPERM if not owner).
+		//-----------------------------------------------------------------------------------------
+		int unlock()
+		{
+			uint32_t expected = getThreadId();
+			if (word.compare_exchange_strong(expected, 0, std::memory_order_release))
+				return 0;
+
+			// waiters present: the kernel hands the lock over to the highest priority one
+			if (futex(FUTEX_UNLOCK_PI_PRIVATE) != 0)
+				return errno;
+
+			return 0;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns owner thread id (0 if unlocked).
+		//-----------------------------------------------------------------------------------------
+		uint32_t getOwner()
+		{
+			return word.load(std::memory_order_relaxed) & FUTEX_TID_MASK;
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		//-----------------------------------------------------------------------------------------
+		// Returns the calling thread's kernel id (cached per thread).
+		//-----------------------------------------------------------------------------------------
+		static uint32_t getThreadId()
+		{
+			static thread_local uint32_t threadId = 0;
+			if (threadId == 0)
+				threadId = (uint32_t) syscall(SYS_gettid);
+
+			return threadId;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Calls futex operation on the lock word.
+		//-----------------------------------------------------------------------------------------
+		long futex(int operation)
+		{
+			return syscall(SYS_futex, (uint32_t*) &word, operation, 0, NULL, NULL, 0);
+		}
+
+		// owner tid | FUTEX_WAITERS | FUTEX_OWNER_DIED, shared with the kernel
+		std::atomic<uint32_t> word;
+		static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+};
+
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#include <stddef.h>
+#include <new>
+
+#ifndef History_h
+#define History_h
+
+// nodes added to the shared pool whenever it runs empty
+#define HISTORY_CHUNK_SIZE 256
+
+//-----------------------------------------------------------------------------------------
+// History class template definition and implementation.
+// Singly linked list of saved thread states (push/pop at the front, read at both ends).
+// Nodes come from a free list shared by all histories of the same type, which grows in
+// chunks and is never shrunk: once warmed up, locking and unlocking allocate nothing.
+// T must be a plain data type (nodes are not constructed).
+// Not thread safe (mutex histories are only changed while the CPU mutex is held).
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class History
+{
+	//-----------------------------------------------------------------------------------------
+	// List node
+	//-----------------------------------------------------------------------------------------
+	struct Node
+	{
+		T data;
+		Node *next;
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Constructor
+		//-----------------------------------------------------------------------------------------
+		History()
+		{
+			head = NULL;
+			tail = NULL;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Destructor (returns nodes to the pool)
+		//-----------------------------------------------------------------------------------------
+		~History()
+		{
+			while (!empty())
+				pop_front();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns true if history is empty.
+		//-----------------------------------------------------------------------------------------
+		bool empty()
+		{
+			return head == NULL;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns most recently saved state.
+		//-----------------------------------------------------------------------------------------
+		T& front()
+		{
+			return head->data;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns first saved state.
+		//-----------------------------------------------------------------------------------------
+		T& back()
+		{
+			return tail->data;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Saves state at the front.
+		//-----------------------------------------------------------------------------------------
+		void push_front(const T& data)
+		{
+			Node *node = allocate();
+			node->data = data;
+			node->next = head;
+			head = node;
+			if (tail == NULL)
+				tail = node;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Removes state at the front.
+		//-----------------------------------------------------------------------------------------
+		void pop_front()
+		{
+			Node *node = head;
+			head = node->next;
+			if (head == NULL)
+				tail = NULL;
+
+			node->next = freeList;
+			freeList = node;
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		//-----------------------------------------------------------------------------------------
+		// Takes a node from the pool, adds a chunk of nodes if the pool is empty.
+		//-----------------------------------------------------------------------------------------
+		static Node* allocate()
+		{
+			if (freeList == NULL)
+			{
+				Node *chunk = (Node*) ::operator new(HISTORY_CHUNK_SIZE * sizeof(Node));
+
+				// link in reverse, so nodes are handed out in address order
+				for (int i = HISTORY_CHUNK_SIZE - 1; i >= 0; i--)
+				{
+					chunk[i].next = freeList;
+					freeList = &chunk[i];
+				}
+			}
+
+			Node *node = freeList;
+			freeList = node->next;
+			return node;
+		}
+
+		// unused nodes shared by all histories of type T
+		static inline Node *freeList = NULL;
+
+		Node *head;
+		Node *tail;
+};
+
+#endif
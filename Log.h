@@ -0,0 +1,63 @@
+#include <stdio.h>
+
+#ifndef Log_h
+#define Log_h
+
+//-----------------------------------------------------------------------------------------
+// Diagnostic log levels. Select at compile time with -DLOG_LEVEL=<n>:
+// 0 = none (quiet release build), 1 = errors, 2 = info (default), 3 = debug.
+//-----------------------------------------------------------------------------------------
+#define LOG_NONE 0
+#define LOG_ERROR 1
+#define LOG_INFO 2
+#define LOG_DEBUG 3
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_INFO
+#endif
+
+//-----------------------------------------------------------------------------------------
+// Log class template definition and implementation.
+// Messages above LOG_LEVEL are discarded with "if constexpr", so neither the call nor the
+// format string is left in the binary. The arguments are still evaluated at the call site
+// (print is a function), use LOG_PRINT where computing them costs something.
+//-----------------------------------------------------------------------------------------
+template<int level>
+class Log
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Returns true if messages of this level are compiled in.
+		//-----------------------------------------------------------------------------------------
+		static constexpr bool enabled()
+		{
+			return level <= LOG_LEVEL;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Prints printf-style message to stdout (errors go to stdout too, like before).
+		//-----------------------------------------------------------------------------------------
+		template<typename... Args>
+		static inline void print(const char* format, Args... args)
+		{
+			if constexpr (enabled())
+			{
+				if constexpr (sizeof...(Args) == 0)
+					fputs(format, stdout);
+				else
+					printf(format, args...);
+			}
+		}
+};
+
+//-----------------------------------------------------------------------------------------
+// Prints a message of level like Log<level>::print, but the arguments are only evaluated
+// if the level is compiled in: a disabled LOG_PRINT leaves no code at all.
+//-----------------------------------------------------------------------------------------
+#define LOG_PRINT(level, ...) \
+	do { if constexpr (Log<level>::enabled()) Log<level>::print(__VA_ARGS__); } while (0)
+
+#endif
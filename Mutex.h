@@ -1,11 +1,26 @@
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
 
+#include "Log.h"
+
+// adaptive mode: spin (pause) iterations before parking in the kernel
+#define MUTEX_SPIN_LIMIT 2000
+
+// adaptive mode: longest pause between two lock attempts (iterations)
+#define MUTEX_BACKOFF_LIMIT 64
+
 #ifndef mutex_h
 #define mutex_h
 
 //-----------------------------------------------------------------------------------------
 // Mutex class definition and implementation.
 // Works as a wrapper around standard pthread_mutex functions.
+// In adaptive mode, lock first retries trylock with exponential backoff for a bounded
+// number of pause iterations and only then parks in the kernel. This pays off for short
+// critical sections when the owner runs on another CPU (on one CPU the owner cannot make
+// progress while we spin).
 //-----------------------------------------------------------------------------------------
 class Mutex
 {
@@ -16,21 +31,22 @@ class Mutex
 		//-----------------------------------------------------------------------------------------
 		// Constructor (initializes mutex)
 		//-----------------------------------------------------------------------------------------
-		Mutex()
+		Mutex(bool adaptive = false)
 		{
-			printf("Initializing mutex ...\n");
+			Log<LOG_INFO>::print("Initializing mutex ...\n");
 			pthread_mutex_init(&mutex, NULL);
+			this->adaptive = adaptive;
 		}
 
 		//-----------------------------------------------------------------------------------------
 		// Destructor
 		//-----------------------------------------------------------------------------------------
-		virtual ~Mutex()
+		~Mutex()
 		{
-			printf("Destroying mutex ...\n");
+			Log<LOG_INFO>::print("Destroying mutex ...\n");
 			int status = pthread_mutex_destroy(&mutex);
 			if (status != 0)
-				printf("Error destroying mutex");
+				Log<LOG_ERROR>::print("Error destroying mutex");
 		}
 
 		//-----------------------------------------------------------------------------------------
@@ -38,6 +54,9 @@ class Mutex
 		//-----------------------------------------------------------------------------------------
 		int lock()
 		{
+			if (adaptive && spin() == 0)
+				return 0;
+
 			return pthread_mutex_lock(&mutex);
 		}
 
@@ -50,18 +69,106 @@ class Mutex
 		}
 
 		//-----------------------------------------------------------------------------------------
-		// Tries to lock mutex, returns 0 (success) or error code (failure).
+		// Tries to lock mutex without blocking, returns 0 (success) or EBUSY (already locked).
 		//-----------------------------------------------------------------------------------------
 		int trylock()
 		{
-			return pthread_mutex_lock(&mutex);
+			return pthread_mutex_trylock(&mutex);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Locks mutex, waits until the absolute CLOCK_MONOTONIC deadline at most.
+		// Returns 0 (success), ETIMEDOUT (deadline passed) or error code (failure).
+		//-----------------------------------------------------------------------------------------
+		int timedlock(const struct timespec* deadline)
+		{
+			if (adaptive && spin() == 0)
+				return 0;
+
+#ifdef __QNX__
+			return pthread_mutex_timedlock_monotonic(&mutex, deadline);
+#else
+			return pthread_mutex_clocklock(&mutex, CLOCK_MONOTONIC, deadline);
+#endif
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Locks mutex, waits for timeout nanoseconds at most.
+		// Returns 0 (success), ETIMEDOUT (timeout expired) or error code (failure).
+		//-----------------------------------------------------------------------------------------
+		int timedlock(long timeout)
+		{
+			struct timespec deadline;
+			clock_gettime(CLOCK_MONOTONIC, &deadline);
+			deadline.tv_sec += timeout / 1000000000L;
+			deadline.tv_nsec += timeout % 1000000000L;
+			if (deadline.tv_nsec >= 1000000000L)
+			{
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000L;
+			}
+
+			return timedlock(&deadline);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Enables/disables adaptive (spin then park) locking.
+		//-----------------------------------------------------------------------------------------
+		void setAdaptive(bool enable)
+		{
+			adaptive = enable;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns true if adaptive locking is enabled.
+		//-----------------------------------------------------------------------------------------
+		bool isAdaptive()
+		{
+			return adaptive;
 		}
 
 	//-----------------------------------------------------------------------------------------
 	// Private members
 	//-----------------------------------------------------------------------------------------
 	private:
-		pthread_mutex_t  mutex;
+		//-----------------------------------------------------------------------------------------
+		// Retries trylock with exponential backoff (1, 2, 4 .. MUTEX_BACKOFF_LIMIT pauses)
+		// until MUTEX_SPIN_LIMIT pauses are spent. Returns 0 (locked) or EBUSY (give up).
+		//-----------------------------------------------------------------------------------------
+		int spin()
+		{
+			int backoff = 1;
+			for (int spent = 0; spent < MUTEX_SPIN_LIMIT; spent += backoff)
+			{
+				if (pthread_mutex_trylock(&mutex) == 0)
+					return 0;
+
+				for (int i = 0; i < backoff; i++)
+					pause();
+
+				if (backoff < MUTEX_BACKOFF_LIMIT)
+					backoff *= 2;
+			}
+
+			return EBUSY;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// CPU relax hint inside spin loops.
+		//-----------------------------------------------------------------------------------------
+		static inline void pause()
+		{
+#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#elif defined(__aarch64__)
+			asm volatile("yield" ::: "memory");
+#else
+			asm volatile("" ::: "memory");
+#endif
+		}
+
+		pthread_mutex_t mutex;
+		bool adaptive;
 };
 
 #endif
@@ -1,5 +1,14 @@
+#include <stdio.h>
+#include <errno.h>
 #include <pthread.h>
-#include <list>
+
+#include "CeilingStack.h"
+#include "Deadlock.h"
+#include "History.h"
+#include "Log.h"
+#include "Profile.h"
+#include "ReadyQueue.h"
+#include "Trace.h"
 
 #ifndef PcMutex_h
 #define PcMutex_h
@@ -7,6 +16,12 @@
 //-----------------------------------------------------------------------------------------
 // PcMutex (Priority Ceiling Mutex) class definition and implementation.
 // Works as a wrapper around standard pthread_mutex functions.
+// Emulated (default): ceiling rules are applied to the ReadyQueue of the simulator, lock
+// never blocks. Native (setNative): PTHREAD_PRIO_PROTECT mutex with the CS priority as its
+// ceiling (see nativePriority), lock blocks and the queue is not used.
+// Immediate (setImmediate, highest locker): the owner runs at the ceiling from lock to
+// unlock, so no other user of the mutex can run and lock finds it free. The kernel
+// protocol of native mode already works this way.
 //-----------------------------------------------------------------------------------------
 class PcMutex
 {
@@ -16,8 +31,7 @@ class PcMutex
 	struct ThreadInfo
 	{
 		int threadId;
-		float *threadPtr;
-		float nativePriority;
+		int nativePriority;
 	};
 
 	//-----------------------------------------------------------------------------------------
@@ -29,148 +43,197 @@ class PcMutex
 		//-----------------------------------------------------------------------------------------
 		PcMutex()
 		{
-			printf("Initializing pcMutex ...\n");
+			Log<LOG_INFO>::print("Initializing pcMutex ...\n");
 			pthread_mutex_init(&pcMutex, NULL);
-			history = new list<ThreadInfo>;
 
-			//Should be determined in advance with static analysis.
+			// set with setCsPriority, computed in advance by TaskSet::computeCeilings
 			csPriority = 0;
+			waiterPriority = 0;
 
 			// initilize lock status
 			locked = false;
+			mutexId = 0;
+			native = false;
+			immediate = false;
 		}
 
 		//-----------------------------------------------------------------------------------------
 		// Destructor
 		//-----------------------------------------------------------------------------------------
-		virtual ~PcMutex()
+		~PcMutex()
 		{
-			printf("Destroying pcMutex ...\n");
+			Log<LOG_INFO>::print("Destroying pcMutex ...\n");
 			int status = pthread_mutex_destroy(&pcMutex);
 			if (status != 0)
-				printf("Error destroying pcMutex");
-			delete history;
+				Log<LOG_ERROR>::print("Error destroying pcMutex");
 		}
 
 		//-----------------------------------------------------------------------------------------
 		// Locks pcMutex for critical section based on priority ceiling protocol.
+		// The system ceiling (highest ceiling among locked mutexes) and its owner are taken from
+		// the ceiling stack, so the cost does not depend on the number of mutexes.
 		// Keeps references (history) to suspended tasks, as manager doesn't provide this functionality.
 		// Returns 0 (success) or error code (failure).
 		//-----------------------------------------------------------------------------------------
-		int lock(int threadId, float priorities[], PcMutex pcMutexes[], int size)
+		int lock(int threadId, ReadyQueue* queue)
 		{
-			int lockStatus = -1;
-
-			bool lockExists = false;
-			bool self = false;
-			PcMutex *lockedMutex;
-
-			// determine and initialize prerequisites
-			for (int i = 0; i < size; i++)
+			if (native)
 			{
-				if (pcMutexes[i].isLocked())
+				int status = pthread_mutex_trylock(&pcMutex);
+				if (status == EBUSY)
 				{
-					lockExists = true;
-					lockedMutex = &pcMutexes[i];
-					if (pcMutexes[i].getCsOwner() == threadId)
-						self = true;
-					else
-						self = false;
+					Profile::contended(getId(), threadId);
+					status = pthread_mutex_lock(&pcMutex);
 				}
+
+				if (status == 0)
+					hold.acquired(getId(), threadId);
+				Trace::record(TRACE_PC_LOCKING, threadId, getId(), 0, 0);
+				return status;
 			}
 
+			if (immediate)
+				return lockImmediate(threadId, queue);
+
+			int lockStatus = -1;
+
+			// mutex holding the system ceiling (NULL if all mutexes are unlocked)
+			PcMutex *lockedMutex = getCeilingMutex();
+			bool self = (lockedMutex != NULL && lockedMutex->getCsOwner() == threadId);
+
 			// if all mutexes are unlocked
-			if (!lockExists)
+			if (lockedMutex == NULL)
 			{
 				// lock CS, update status, save info about locking thread
-				printf("\nPcMutex: locking CS%d, thread %d", getId(), threadId);
+				Trace::record(TRACE_PC_LOCKING, threadId, getId(), 0, 0);
 				lockStatus = pthread_mutex_trylock(&pcMutex);
 				if (lockStatus != 0)
-					printf("\nPcMutex: ERROR LOCKING MUTEX id: %d", getId());
+					Trace::record(TRACE_PC_LOCK_ERROR, threadId, getId(), 0, 0);
 				else
-					locked = true;
+				{
+					pushCeiling();
+					hold.acquired(getId(), threadId);
+				}
 
-				printf("\nPcMutex: saving thread %d state", threadId);
-				saveState(createDataObj(priorities, threadId));
+				Trace::record(TRACE_PC_SAVE, threadId, getId(), 0, 0);
+				saveState(createDataObj(queue, threadId));
 			}
 			// at least one mutex is locked by another or same thread
-			else if (self || priorities[threadId] > getCsPriority())
+			else if (self || queue->getPriority(threadId) > lockedMutex->getCsPriority())
 			{
-				// if locking thread priority > ceiling OR another CS is locked by the same thread
+				// if locking thread priority > system ceiling OR the system ceiling is held by the same thread
 				// AND current CS is not locked => lock CS
 				if(!isLocked())
 				{
 					// lock CS, update status, save info about locking thread
-					printf("\nPcMutex: locking CS%d, thread %d", getId(), threadId);
+					Trace::record(TRACE_PC_LOCKING, threadId, getId(), 0, 0);
 					lockStatus = pthread_mutex_trylock(&pcMutex);
 					if (lockStatus != 0)
-						printf("\nPcMutex: ERROR LOCKING MUTEX id: %d", getId());
+						Trace::record(TRACE_PC_LOCK_ERROR, threadId, getId(), 0, 0);
 					else
-						locked = true;
+					{
+						pushCeiling();
+						hold.acquired(getId(), threadId);
+					}
 
-					printf("\nPcMutex: saving thread %d state", threadId);
-					saveState(createDataObj(priorities, threadId));
+					Trace::record(TRACE_PC_SAVE, threadId, getId(), 0, 0);
+					saveState(createDataObj(queue, threadId));
 				}
-				// suspend locking thread by setting its status to 0
+				// suspend locking thread
 				else
 				{
-					printf("\nPcMutex: CS%d already locked by thread %d", getId(), lockedMutex->getCsOwner());
-					printf("\nPcMutex: saving thread %d state", threadId);
-					saveState(createDataObj(priorities, threadId));
+					Trace::record(TRACE_PC_ALREADY_LOCKED, threadId, getId(), 0, getCsOwner());
+					Profile::contended(getId(), threadId);
+					Deadlock::blocked(threadId, getId(), getCsOwner());
+					Trace::record(TRACE_PC_SAVE, threadId, getId(), 0, 0);
+					saveState(createDataObj(queue, threadId));
 
-					printf("\nPcMutex: suspend thread %d", threadId);
-					priorities[threadId] = 0;
+					Trace::record(TRACE_PC_SUSPEND, threadId, getId(), 0, 0);
+					queue->suspend(threadId);
 				}
 			}
-			// if (locking priority) > (locked priority), transfer priority (inheritance) and suspend locking thread
+			// blocked by the system ceiling: wait for the unlock of the ceiling mutex and, if
+			// (locking priority) > (locked priority), transfer priority (inheritance)
 			else
 			{
 				// identify target (locked) mutex owner (thread)
+				Profile::contended(getId(), threadId);
 				int lockedThreadId = lockedMutex->getCsOwner();
-				if ( priorities[threadId] > priorities[lockedThreadId])
-				{
-					// save donor thread info at locked/target mutex
-					printf("\nPcMutex: saving thread %d state on target CS%d", lockedThreadId, lockedMutex->getId());
-					lockedMutex->saveState(createDataObj(priorities, threadId));
 
+				// save waiting thread info at locked/target mutex (resumed by its unlock)
+				Trace::record(TRACE_PC_SAVE_TARGET, lockedThreadId, lockedMutex->getId(), 0, 0);
+				lockedMutex->saveState(createDataObj(queue, threadId));
+
+				if (queue->getPriority(threadId) > queue->getPriority(lockedThreadId))
+				{
 					// transfer priority to thread that is locking target mutex
-					printf("\nPcMutex: transferring priority %.2f to thread %d", priorities[threadId], lockedThreadId);
-					priorities[lockedThreadId] = priorities[threadId];
+					Trace::record(TRACE_PC_TRANSFER, lockedThreadId, getId(), queue->getPriority(threadId), 0);
+					Profile::donated(lockedMutex->getId());
+					queue->setPriority(lockedThreadId, queue->getPriority(threadId));
 				}
 
-				// suspend locking thread by setting its priority to 0
-				printf("\nPcMutex: suspend thread %d", threadId);
-				priorities[threadId] = 0;
+				// suspend locking thread (waits for the owner of the system ceiling)
+				Trace::record(TRACE_PC_SUSPEND, threadId, getId(), 0, 0);
+				queue->suspend(threadId);
+				Deadlock::blocked(threadId, lockedMutex->getId(), lockedThreadId);
 			}
 
 			return lockStatus;
 		}
 
 		//-----------------------------------------------------------------------------------------
-		// Unlocks pcMutex and restores thread priorities to their original values.
-		// This also resumes suspended priorities (with priority set to 0).
+		// Unlocks pcMutex, restores the priorities of the suspended threads and resumes them.
+		// The owner drops to the highest of its priority before its first held lock, the
+		// ceilings of the immediate mutexes it still holds and the priorities of the threads
+		// waiting for its other mutexes (unlock in any order). O(locked mutexes).
+		// Returns 0 (success) or error code (EPERM if the emulated mutex is not locked).
 		//-----------------------------------------------------------------------------------------
-		int unlock()
+		int unlock(ReadyQueue* queue)
 		{
+			// an unmatched unlock finds neither a ceiling stack entry nor an owner in history
+			if (!native && (!locked || history.empty()))
+			{
+				Trace::record(TRACE_PC_UNLOCK_ERROR, 0, getId(), 0, 0);
+				return EPERM;
+			}
+
+			hold.released(getId());
+
 			int unlockStatus = pthread_mutex_unlock(&pcMutex);
-			if (unlockStatus == 0)
+			if (native)
 			{
-				printf("\nPcMutex: unlocking CS%d, recovering priorities, resuming suspended threads", getId());
-				while(!history->empty())
-				{
-					// recover native priorities (also resumes suspended threads)
-					printf("\nPcMutex: recovering thread %d priority to %.2f",
-							history->front().threadId,
-							history->front().nativePriority);
-					*(history->front().threadPtr) = history->front().nativePriority;
-					history->pop_front();
-				}
+				Trace::record(TRACE_PC_RESET, 0, getId(), 0, 0);
+				return unlockStatus;
+			}
 
-				printf("\nPcMutex: resetting CS locked status");
-				locked = false;
+			if (unlockStatus != 0)
+			{
+				Trace::record(TRACE_PC_UNLOCK_ERROR, 0, getId(), 0, 0);
+				return unlockStatus;
+			}
+
+			Trace::record(TRACE_PC_UNLOCKING, 0, getId(), 0, 0);
+			while (history.front().threadId != history.back().threadId)
+			{
+				// recover native priorities and resume suspended threads
+				Trace::record(TRACE_PC_RECOVER, history.front().threadId, getId(),
+						history.front().nativePriority, 0);
+				queue->setPriority(history.front().threadId, history.front().nativePriority);
+				queue->resume(history.front().threadId);
+				Deadlock::unblocked(history.front().threadId);
+				history.pop_front();
 			}
-			else
-				printf("\nPcMutex: ERROR UNLOCKING MUTEX");
+
+			int owner = history.front().threadId;
+			int priority = history.front().nativePriority;
+			history.pop_front();
+			waiterPriority = 0;
+			popCeiling();
+			priority = getHeldPriority(owner, priority);
+
+			Trace::record(TRACE_PC_RECOVER, owner, getId(), priority, 0);
+			queue->setPriority(owner, priority);
+			Trace::record(TRACE_PC_RESET, 0, getId(), 0, 0);
 
 			return unlockStatus;
 		}
@@ -178,13 +241,12 @@ class PcMutex
 		//-----------------------------------------------------------------------------------------
 		// Creates ThreadInfo data holder. Returns created structure.
 		//-----------------------------------------------------------------------------------------
-		ThreadInfo createDataObj(float priorities[], int threadId)
+		ThreadInfo createDataObj(ReadyQueue* queue, int threadId)
 		{
-			printf("\nPcMutex: creating thread %d data holder", threadId);
+			Trace::record(TRACE_PC_DATA_HOLDER, threadId, getId(), 0, 0);
 			ThreadInfo threadData;
 			threadData.threadId = threadId;
-			threadData.threadPtr = &priorities[threadId];
-			threadData.nativePriority = priorities[threadId];
+			threadData.nativePriority = queue->getPriority(threadId);
 
 			return threadData;
 		}
@@ -194,25 +256,88 @@ class PcMutex
 		//-----------------------------------------------------------------------------------------
 		void saveState(ThreadInfo threadData)
 		{
-			history->push_front(threadData);
+			// the owner is saved first, the others wait (and donate their priority)
+			if (!history.empty() && threadData.nativePriority > waiterPriority)
+				waiterPriority = threadData.nativePriority;
+			history.push_front(threadData);
 		}
 
 		//-----------------------------------------------------------------------------------------
 		// Sets critical section priority.
 		//-----------------------------------------------------------------------------------------
-		void setCsPriority(float priority)
+		void setCsPriority(int priority)
 		{
 			csPriority = priority;
+			if (native)
+			{
+				int oldCeiling;
+				pthread_mutex_setprioceiling(&pcMutex, nativePriority(priority), &oldCeiling);
+			}
 		}
 
 		//-----------------------------------------------------------------------------------------
 		// Returns critical section priority.
 		//-----------------------------------------------------------------------------------------
-		float getCsPriority()
+		int getCsPriority()
 		{
 			return csPriority;
 		}
 
+		//-----------------------------------------------------------------------------------------
+		// Selects native (kernel enforced, PTHREAD_PRIO_PROTECT) or emulated protocol.
+		// The mutex must be unlocked. Returns 0 (success) or error code (failure).
+		//-----------------------------------------------------------------------------------------
+		int setNative(bool enable)
+		{
+			pthread_mutexattr_t attributes;
+			pthread_mutexattr_init(&attributes);
+			int status = pthread_mutexattr_setprotocol(&attributes,
+					enable ? PTHREAD_PRIO_PROTECT : PTHREAD_PRIO_NONE);
+			if (status == 0 && enable)
+				status = pthread_mutexattr_setprioceiling(&attributes, nativePriority(csPriority));
+
+			if (status == 0)
+			{
+				pthread_mutex_destroy(&pcMutex);
+				status = pthread_mutex_init(&pcMutex, &attributes);
+			}
+			pthread_mutexattr_destroy(&attributes);
+
+			if (status != 0)
+			{
+				Log<LOG_ERROR>::print("Error setting pcMutex protocol: %d\n", status);
+				return status;
+			}
+
+			native = enable;
+			return 0;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns true if the kernel enforces the protocol.
+		//-----------------------------------------------------------------------------------------
+		bool isNative()
+		{
+			return native;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Selects immediate (highest locker) or original ceiling protocol (emulated only).
+		// The mutex must be unlocked.
+		//-----------------------------------------------------------------------------------------
+		void setImmediate(bool enable)
+		{
+			immediate = enable;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns true if the owner is raised to the ceiling on lock.
+		//-----------------------------------------------------------------------------------------
+		bool isImmediate()
+		{
+			return immediate;
+		}
+
 		//-----------------------------------------------------------------------------------------
 		// Returns mutex lock status.
 		//-----------------------------------------------------------------------------------------
@@ -226,7 +351,15 @@ class PcMutex
 		//-----------------------------------------------------------------------------------------
 		int getCsOwner()
 		{
-			return history->back().threadId;
+			return history.back().threadId;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the mutex holding the system ceiling, NULL if no mutex is locked.
+		//-----------------------------------------------------------------------------------------
+		static PcMutex* getCeilingMutex()
+		{
+			return ceilingStack.getCeilingMutex();
 		}
 
 		//-----------------------------------------------------------------------------------------
@@ -249,11 +382,108 @@ class PcMutex
 	// Private members
 	//-----------------------------------------------------------------------------------------
 	private:
+		//-----------------------------------------------------------------------------------------
+		// Immediate ceiling lock: saves the owner's priority (restored by unlock) and raises it
+		// to the ceiling. A busy mutex (ceiling below a user's priority, or a holder of the
+		// original protocol) suspends the thread until unlock, as the original protocol does.
+		//-----------------------------------------------------------------------------------------
+		int lockImmediate(int threadId, ReadyQueue* queue)
+		{
+			ThreadInfo threadData;
+			threadData.threadId = threadId;
+			threadData.nativePriority = queue->getPriority(threadId);
+
+			int lockStatus = pthread_mutex_trylock(&pcMutex);
+			if (lockStatus != 0)
+			{
+				Trace::record(TRACE_PC_ALREADY_LOCKED, threadId, getId(), 0, getCsOwner());
+				Profile::contended(getId(), threadId);
+				Deadlock::blocked(threadId, getId(), getCsOwner());
+				saveState(threadData);
+
+				Trace::record(TRACE_PC_SUSPEND, threadId, getId(), 0, 0);
+				queue->suspend(threadId);
+				return lockStatus;
+			}
+
+			Trace::record(TRACE_PC_LOCKING, threadId, getId(), 0, 0);
+			pushCeiling();
+			hold.acquired(getId(), threadId);
+			saveState(threadData);
+
+			if (threadData.nativePriority < csPriority)
+			{
+				Trace::record(TRACE_PC_RAISE, threadId, getId(), csPriority, 0);
+				queue->setPriority(threadId, csPriority);
+			}
+
+			return lockStatus;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the priority of owner after unlocking this mutex (locked at priority): the
+		// highest of its priority before its first held lock and the priorities the mutexes it
+		// still holds impose (ceiling if immediate, highest waiter otherwise). The first held
+		// mutex keeps the priority before the first lock, a later lock saved a raised priority.
+		// O(locked mutexes).
+		//-----------------------------------------------------------------------------------------
+		int getHeldPriority(int owner, int priority)
+		{
+			PcMutex *first = NULL;
+			int held = 0;
+			for (size_t i = 0; i < ceilingStack.size(); i++)
+			{
+				PcMutex *mutex = ceilingStack.getMutex(i);
+				if (mutex->getCsOwner() != owner)
+					continue;
+
+				if (first == NULL)
+					first = mutex;
+				int imposed = mutex->immediate ? mutex->getCsPriority() : mutex->waiterPriority;
+				if (imposed > held)
+					held = imposed;
+			}
+
+			if (first != NULL)
+			{
+				if (first->history.back().nativePriority > priority)
+					first->history.back().nativePriority = priority;
+				priority = first->history.back().nativePriority;
+			}
+
+			return (held > priority) ? held : priority;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Pushes this mutex on the ceiling stack (marks it locked).
+		//-----------------------------------------------------------------------------------------
+		void pushCeiling()
+		{
+			ceilingStack.push(this);
+			locked = true;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Pops this mutex from the ceiling stack (marks it unlocked).
+		//-----------------------------------------------------------------------------------------
+		void popCeiling()
+		{
+			locked = false;
+			ceilingStack.pop(this);
+		}
+
+		// locked mutexes in locking order, shared by all PcMutex instances
+		static inline CeilingStack<PcMutex> ceilingStack;
+
 		pthread_mutex_t pcMutex;
-		list<ThreadInfo> *history;
-		float csPriority;
+		History<ThreadInfo> history;
+		int csPriority;
+		int waiterPriority;			// highest priority of the threads waiting in history
 		bool locked;
 		int mutexId;
+		bool native;
+		bool immediate;				// highest locker protocol
+		ProfileHold hold;
 };
 
 #endif
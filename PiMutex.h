@@ -1,5 +1,14 @@
+#include <stdio.h>
+#include <errno.h>
 #include <pthread.h>
-#include <list>
+#include <vector>
+
+#include "Deadlock.h"
+#include "History.h"
+#include "Log.h"
+#include "Profile.h"
+#include "ReadyQueue.h"
+#include "Trace.h"
 
 #ifndef PiMutex_h
 #define PiMutex_h
@@ -7,6 +16,12 @@
 //-----------------------------------------------------------------------------------------
 // PiMutex (Priority Inheritance Mutex) class definition and implementation.
 // Works as a wrapper around standard pthread_mutex functions.
+// Emulated (default): priorities are inherited in the ReadyQueue of the simulator, lock
+// never blocks. Native (setNative): PTHREAD_PRIO_INHERIT mutex, the kernel boosts the owner
+// (SCHED_FIFO threads), lock blocks and the queue is not used.
+// Inheritance is transitive: a donation follows the chain of owners blocked on other
+// PiMutexes (O(chain length)). A thread runs at the highest of its base priority and the
+// priorities donated to the mutexes it still holds, in any release order.
 //-----------------------------------------------------------------------------------------
 class PiMutex
 {
@@ -15,8 +30,18 @@ class PiMutex
 	//-----------------------------------------------------------------------------------------
 	struct ThreadInfo
 	{
-		float *threadPtr;
-		float nativePriority;
+		int threadId;
+		int nativePriority;
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Emulated protocol state of a thread (shared by all PiMutexes)
+	//-----------------------------------------------------------------------------------------
+	struct ThreadState
+	{
+		int basePriority;		// priority without donations
+		PiMutex *blockedOn;		// mutex the thread waits for (NULL = none)
+		PiMutex *held;			// mutexes the thread holds (most recent first)
 	};
 
 	//-----------------------------------------------------------------------------------------
@@ -28,111 +53,283 @@ class PiMutex
 		//-----------------------------------------------------------------------------------------
 		PiMutex()
 		{
-			printf("Initializing piMutex ...\n");
+			Log<LOG_INFO>::print("Initializing piMutex ...\n");
 			pthread_mutex_init(&piMutex, NULL);
-			history = new list<ThreadInfo>;
 			csPriority = 0;
+			mutexId = 0;
+			native = false;
+			owner = 0;
+			nextHeld = NULL;
 		}
 
 		//-----------------------------------------------------------------------------------------
 		// Destructor
 		//-----------------------------------------------------------------------------------------
-		virtual ~PiMutex()
+		~PiMutex()
 		{
-			printf("Destroying piMutex ...\n");
+			Log<LOG_INFO>::print("Destroying piMutex ...\n");
 			int status = pthread_mutex_destroy(&piMutex);
 			if (status != 0)
-				printf("Error destroying piMutex");
-			delete history;
+				Log<LOG_ERROR>::print("Error destroying piMutex");
 		}
 
 		//-----------------------------------------------------------------------------------------
-		// Locks piMutex for critical section with highest known thread priority.
-		// Keeps references to priority donors (history).
+		// Locks piMutex for critical section.
+		// A thread that finds it locked waits (suspended, retries after unlock) and donates its
+		// priority to the owner and, if the owner waits too, along the chain of owners.
 		// Returns 0 (success) or error code (failure).
 		//-----------------------------------------------------------------------------------------
-		int lock(float *priorityPtr)
+		int lock(int threadId, ReadyQueue* queue)
 		{
+			if (native)
+			{
+				int status = pthread_mutex_trylock(&piMutex);
+				if (status == EBUSY)
+				{
+					Profile::contended(getId(), threadId);
+					status = pthread_mutex_lock(&piMutex);
+				}
+
+				if (status == 0)
+					hold.acquired(getId(), threadId);
+				Trace::record(TRACE_PI_LOCKING, threadId, getId(), 0, 0);
+				return status;
+			}
+
+			// without held mutexes there are no donations, the priority is the base priority
+			ThreadState &thread = getThreadState(threadId);
+			int priority = queue->getPriority(threadId);
+			if (thread.held == NULL)
+				thread.basePriority = priority;
+
 			int lockStatus = pthread_mutex_trylock(&piMutex);
 
 			// if locked successfully
 			if (lockStatus == 0)
 			{
-				printf("\nPiMutex: locking CS");
+				Trace::record(TRACE_PI_LOCKING, threadId, getId(), priority, 0);
+				hold.acquired(getId(), threadId);
 
-				// keep reference to the locking thread's priority
-				ThreadInfo threadData;
-				threadData.threadPtr = priorityPtr;
-				threadData.nativePriority = *priorityPtr;
-				history->push_front(threadData);
+				owner = threadId;
+				nextHeld = thread.held;
+				thread.held = this;
 
-				if (csPriority > *priorityPtr)
-				{
-					printf("\nPiMutex: inherit CS priority: %.2f", *priorityPtr);
-					*priorityPtr = csPriority;
-				}
-				else
-				{
-					printf("\nPiMutex: update CS priority to: %.2f", *priorityPtr);
-					csPriority = *priorityPtr;
-				}
+				Trace::record(TRACE_PI_UPDATE_CS, threadId, getId(), priority, 0);
 			}
-			// if already locked by lower priority thread
-			else if (lockStatus == 16 && csPriority < *priorityPtr)
+			// already locked: wait for the owner
+			else
 			{
-				printf("\nPiMutex: CS already locked, inherit priority: %.2f", *priorityPtr);
-
-				// update CS and locking thread's priority to that of the attempting thread
-				csPriority = *priorityPtr;
-				*(history->back().threadPtr) = *priorityPtr;
+				Profile::contended(getId(), threadId);
 
-				// keep reference to the suspended thread's priority
+				// keep reference to the suspended thread (resumed on unlock)
 				ThreadInfo threadData;
-				threadData.threadPtr = priorityPtr;
-				threadData.nativePriority = *priorityPtr;
-				history->push_front(threadData);
+				threadData.threadId = threadId;
+				threadData.nativePriority = priority;
+				history.push_front(threadData);
+				thread.blockedOn = this;
+
+				if (csPriority < priority)
+					csPriority = priority;
+
+				// donate to the owner (and to the owners it waits for)
+				if (queue->getPriority(owner) < priority)
+				{
+					Trace::record(TRACE_PI_ALREADY_LOCKED, threadId, getId(), priority, 0);
+					Profile::donated(getId());
+					propagate(priority, queue);
+				}
 
-				printf("\nPiMutex: suspend higher priority thread");
-				*priorityPtr = 0;	// set its priority to 0
+				Trace::record(TRACE_PI_SUSPEND, threadId, getId(), priority, 0);
+				queue->suspend(threadId);
+				Deadlock::blocked(threadId, getId(), owner);
 			}
-			else
-				printf("\nPiMutex: ignoring locking attempts from lower priority threads");
 
 			return lockStatus;
 		}
 
 		//-----------------------------------------------------------------------------------------
-		// Unlocks piMutex and restores thread priorities to their original values.
-		// This also resumes suspended priorities (with priority set to 0).
+		// Unlocks piMutex, resumes waiting threads (they retry the lock) and drops the
+		// donations to this mutex: the owner keeps those of the mutexes it still holds.
+		// Returns 0 (success) or error code (EPERM if threadId does not own the mutex).
 		//-----------------------------------------------------------------------------------------
-		int unlock(float *priorityPtr)
+		int unlock(int threadId, ReadyQueue* queue)
 		{
+			// emulated mutexes track their owner, unlocking one of another thread is undefined
+			if (!native && owner != threadId)
+				return EPERM;
+
+			hold.released(getId());
+
 			int unlockStatus = pthread_mutex_unlock(&piMutex);
+			if (native)
+			{
+				Trace::record(TRACE_PI_UNLOCKED, threadId, getId(), 0, 0);
+				return unlockStatus;
+			}
 
 			if (unlockStatus == 0)
 			{
-				printf("\nPiMutex: unlocked, recovering priorities, resuming suspended threads");
-				while(!history->empty())
+				Trace::record(TRACE_PI_UNLOCKED, threadId, getId(), 0, 0);
+				while(!history.empty())
 				{
-					// recover native priorities (also resumes suspended threads)
-					*(history->front().threadPtr) = history->front().nativePriority;
-					history->pop_front();
-
-					// reset CS priority
-					csPriority = 0;
+					// resume suspended threads
+					getThreadState(history.front().threadId).blockedOn = NULL;
+					queue->resume(history.front().threadId);
+					Deadlock::unblocked(history.front().threadId);
+					history.pop_front();
 				}
+
+				// reset CS priority, remove from the owner's held mutexes (any order)
+				csPriority = 0;
+				ThreadState &thread = getThreadState(owner);
+				PiMutex **link = &thread.held;
+				while (*link != NULL && *link != this)
+					link = &(*link)->nextHeld;
+				if (*link != NULL)
+					*link = nextHeld;
+				nextHeld = NULL;
+
+				queue->setPriority(owner, getInheritedPriority(owner));
+				owner = 0;
 			}
 
 			return unlockStatus;
 		}
 
+		//-----------------------------------------------------------------------------------------
+		// Selects native (kernel enforced, PTHREAD_PRIO_INHERIT) or emulated protocol.
+		// The mutex must be unlocked. Returns 0 (success) or error code (failure).
+		//-----------------------------------------------------------------------------------------
+		int setNative(bool enable)
+		{
+			pthread_mutexattr_t attributes;
+			pthread_mutexattr_init(&attributes);
+			int status = pthread_mutexattr_setprotocol(&attributes,
+					enable ? PTHREAD_PRIO_INHERIT : PTHREAD_PRIO_NONE);
+
+			if (status == 0)
+			{
+				pthread_mutex_destroy(&piMutex);
+				status = pthread_mutex_init(&piMutex, &attributes);
+			}
+			pthread_mutexattr_destroy(&attributes);
+
+			if (status != 0)
+			{
+				Log<LOG_ERROR>::print("Error setting piMutex protocol: %d\n", status);
+				return status;
+			}
+
+			native = enable;
+			return 0;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns true if the kernel enforces the protocol.
+		//-----------------------------------------------------------------------------------------
+		bool isNative()
+		{
+			return native;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Sets mutex id.
+		//-----------------------------------------------------------------------------------------
+		void setId(int id)
+		{
+			mutexId = id;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns mutex id.
+		//-----------------------------------------------------------------------------------------
+		int getId()
+		{
+			return mutexId;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns owner thread (0 = not locked, emulated protocol only).
+		//-----------------------------------------------------------------------------------------
+		int getOwner()
+		{
+			return owner;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns mutex the thread waits for (NULL = none, emulated protocol only).
+		//-----------------------------------------------------------------------------------------
+		static PiMutex* getBlockedOn(int threadId)
+		{
+			return getThreadState(threadId).blockedOn;
+		}
+
 	//-----------------------------------------------------------------------------------------
 	// Private members
 	//-----------------------------------------------------------------------------------------
 	private:
 		pthread_mutex_t piMutex;
-		list<ThreadInfo> *history;
-		float csPriority;
+		History<ThreadInfo> history;	// suspended threads
+		int csPriority;					// highest priority of suspended threads (donated)
+		int mutexId;
+		bool native;
+		ProfileHold hold;
+		int owner;
+		PiMutex *nextHeld;				// next mutex held by the owner
+
+		static inline std::vector<ThreadState> threads;		// by thread id
+
+		//-----------------------------------------------------------------------------------------
+		// Returns protocol state of thread (grows the table on first use of an id).
+		//-----------------------------------------------------------------------------------------
+		static ThreadState& getThreadState(int threadId)
+		{
+			if ((int) threads.size() <= threadId)
+			{
+				ThreadState initial = { 0, NULL, NULL };
+				threads.resize(threadId + 1, initial);
+			}
+
+			return threads[threadId];
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the priority thread inherits: highest of its base priority and the
+		// donations to the mutexes it holds. O(held mutexes).
+		//-----------------------------------------------------------------------------------------
+		static int getInheritedPriority(int threadId)
+		{
+			ThreadState &thread = getThreadState(threadId);
+			int priority = thread.basePriority;
+			for (PiMutex *mutex = thread.held; mutex != NULL; mutex = mutex->nextHeld)
+			{
+				if (mutex->csPriority > priority)
+					priority = mutex->csPriority;
+			}
+
+			return priority;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Raises the owner to priority and follows the chain while owners are blocked on
+		// other mutexes. Priorities in a blocked chain only rise (donors cannot leave before
+		// the owner unlocks), so each step is O(1). Stops at an owner that already runs at
+		// priority, which also ends a cycle (deadlock).
+		//-----------------------------------------------------------------------------------------
+		void propagate(int priority, ReadyQueue* queue)
+		{
+			PiMutex *mutex = this;
+			while (mutex != NULL && queue->getPriority(mutex->owner) < priority)
+			{
+				if (mutex != this)
+					Trace::record(TRACE_PI_PROPAGATE, mutex->owner, mutex->getId(), priority, 0);
+				queue->setPriority(mutex->owner, priority);
+
+				mutex = getThreadState(mutex->owner).blockedOn;
+				if (mutex != NULL && mutex->csPriority < priority)
+					mutex->csPriority = priority;
+			}
+		}
 };
 
 #endif
@@ -0,0 +1,367 @@
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <vector>
+
+#include "Profile.h"
+
+//---------------------------------------------------------------------------------------------
+// Profile implementation: per-thread counter tables, merging and reporting.
+//---------------------------------------------------------------------------------------------
+
+// mutex counters per table page
+#define PROFILE_PAGE_SIZE 256
+#define PROFILE_PAGES (PROFILE_MAX_MUTEXES / PROFILE_PAGE_SIZE)
+
+	//-----------------------------------------------------------------------------------------
+	// Counters of one mutex in one thread. Only the owning thread writes (relaxed load and
+	// store, no read-modify-write), collect reads them at any time.
+	//-----------------------------------------------------------------------------------------
+	struct ProfileCounters
+	{
+		std::atomic<uint64_t> acquisitions;
+		std::atomic<uint64_t> contentions;
+		std::atomic<uint64_t> donations;
+		std::atomic<uint64_t> hold[PROFILE_BUCKETS];
+		std::atomic<uint64_t> wait[PROFILE_BUCKETS];
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Counters of PROFILE_PAGE_SIZE consecutive mutex ids (allocated on first use).
+	//-----------------------------------------------------------------------------------------
+	struct ProfilePage
+	{
+		std::atomic<ProfileCounters*> counters[PROFILE_PAGE_SIZE];
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Pending wait of one task: mutex it waits for (-1 = none) and first attempt.
+	//-----------------------------------------------------------------------------------------
+	struct ProfileWait
+	{
+		int mutexId;
+		long long start;
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Counter table of one thread, reused by a later thread once the owner exited
+	// (counts only add up, so the new owner simply continues).
+	//-----------------------------------------------------------------------------------------
+	struct ProfileTable
+	{
+		std::atomic<ProfilePage*> pages[PROFILE_PAGES];
+		std::atomic<bool> retired;
+		ProfileTable *next;			// registry link
+
+		std::vector<ProfileWait> waits;	// pending waits by task id (tasks run by the owner)
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Releases the thread's table for reuse when the owning thread exits.
+	//-----------------------------------------------------------------------------------------
+	struct ProfileTableOwner
+	{
+		ProfileTable *table;
+
+		~ProfileTableOwner()
+		{
+			if (table != NULL)
+				table->retired.store(true, std::memory_order_release);
+		}
+	};
+
+	static std::atomic<ProfileTable*> registry(NULL);	// all tables, append only
+	static std::atomic<bool> profiling(false);
+	static std::atomic<int> maxMutexId(-1);
+	static thread_local ProfileTableOwner owner = {NULL};
+
+	//-----------------------------------------------------------------------------------------
+	// Returns CLOCK_MONOTONIC time in nanoseconds.
+	//-----------------------------------------------------------------------------------------
+	static long long now()
+	{
+		struct timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return (long long) time.tv_sec * 1000000000LL + time.tv_nsec;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Adds one to a counter written by this thread only.
+	//-----------------------------------------------------------------------------------------
+	static inline void increment(std::atomic<uint64_t>& counter)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns the calling thread's table, reuses a table of an exited thread if possible.
+	//-----------------------------------------------------------------------------------------
+	static ProfileTable* attachTable()
+	{
+		ProfileTable *table = NULL;
+		for (ProfileTable *t = registry.load(std::memory_order_acquire); t != NULL && table == NULL; t = t->next)
+		{
+			bool retired = true;
+			if (t->retired.compare_exchange_strong(retired, false))
+				table = t;
+		}
+
+		if (table == NULL)
+		{
+			table = new ProfileTable();
+			table->next = registry.load(std::memory_order_relaxed);
+			while (!registry.compare_exchange_weak(table->next, table, std::memory_order_release))
+				;
+		}
+
+		return table;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns the calling thread's counters of mutex (NULL if the id is out of range).
+	//-----------------------------------------------------------------------------------------
+	static ProfileCounters* getCounters(int mutexId)
+	{
+		if (mutexId < 0 || mutexId >= PROFILE_MAX_MUTEXES)
+			return NULL;
+
+		if (owner.table == NULL)
+			owner.table = attachTable();
+
+		std::atomic<ProfilePage*> &pageSlot = owner.table->pages[mutexId / PROFILE_PAGE_SIZE];
+		ProfilePage *page = pageSlot.load(std::memory_order_relaxed);
+		if (page == NULL)
+		{
+			page = new ProfilePage();
+			pageSlot.store(page, std::memory_order_release);
+		}
+
+		std::atomic<ProfileCounters*> &slot = page->counters[mutexId % PROFILE_PAGE_SIZE];
+		ProfileCounters *counters = slot.load(std::memory_order_relaxed);
+		if (counters == NULL)
+		{
+			counters = new ProfileCounters();
+			slot.store(counters, std::memory_order_release);
+
+			int highest = maxMutexId.load(std::memory_order_relaxed);
+			while (highest < mutexId && !maxMutexId.compare_exchange_weak(highest, mutexId))
+				;
+		}
+
+		return counters;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Starts profiling.
+	//-----------------------------------------------------------------------------------------
+	void Profile::start()
+	{
+		profiling.store(true);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Stops profiling.
+	//-----------------------------------------------------------------------------------------
+	void Profile::stop()
+	{
+		profiling.store(false);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Counts an acquisition, records the wait time (0 if the mutex was free).
+	//-----------------------------------------------------------------------------------------
+	long long Profile::acquired(int mutexId, int threadId)
+	{
+		if (!profiling.load(std::memory_order_relaxed))
+			return 0;
+
+		ProfileCounters *counters = getCounters(mutexId);
+		if (counters == NULL)
+			return 0;
+
+		long long time = now();
+		long long wait = 0;
+		std::vector<ProfileWait> &waits = owner.table->waits;
+		if (threadId >= 0 && threadId < (int) waits.size() && waits[threadId].mutexId == mutexId)
+		{
+			wait = time - waits[threadId].start;
+			waits[threadId].mutexId = -1;
+		}
+
+		increment(counters->acquisitions);
+		increment(counters->wait[bucket(wait)]);
+		return time;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Starts a wait, repeated attempts for the same mutex belong to the same wait.
+	//-----------------------------------------------------------------------------------------
+	void Profile::contended(int mutexId, int threadId)
+	{
+		if (!profiling.load(std::memory_order_relaxed) || threadId < 0)
+			return;
+
+		ProfileCounters *counters = getCounters(mutexId);
+		if (counters == NULL)
+			return;
+
+		std::vector<ProfileWait> &waits = owner.table->waits;
+		if (threadId >= (int) waits.size())
+		{
+			ProfileWait none = { -1, 0 };
+			waits.resize(threadId + 1, none);
+		}
+		if (waits[threadId].mutexId == mutexId)
+			return;
+
+		waits[threadId].mutexId = mutexId;
+		waits[threadId].start = now();
+		increment(counters->contentions);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Counts a priority donation.
+	//-----------------------------------------------------------------------------------------
+	void Profile::donated(int mutexId)
+	{
+		if (!profiling.load(std::memory_order_relaxed))
+			return;
+
+		ProfileCounters *counters = getCounters(mutexId);
+		if (counters != NULL)
+			increment(counters->donations);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Records hold time. Attributed to the releasing thread, which normally is the owner.
+	//-----------------------------------------------------------------------------------------
+	void Profile::released(int mutexId, long long holdStart)
+	{
+		if (!profiling.load(std::memory_order_relaxed) || holdStart == 0)
+			return;
+
+		ProfileCounters *counters = getCounters(mutexId);
+		if (counters != NULL)
+			increment(counters->hold[bucket(now() - holdStart)]);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Sums the counters of mutex over all thread tables.
+	//-----------------------------------------------------------------------------------------
+	bool Profile::collect(int mutexId, MutexProfile* profile)
+	{
+		memset(profile, 0, sizeof(MutexProfile));
+		if (mutexId < 0 || mutexId >= PROFILE_MAX_MUTEXES)
+			return false;
+
+		bool used = false;
+		for (ProfileTable *t = registry.load(std::memory_order_acquire); t != NULL; t = t->next)
+		{
+			ProfilePage *page = t->pages[mutexId / PROFILE_PAGE_SIZE].load(std::memory_order_acquire);
+			if (page == NULL)
+				continue;
+
+			ProfileCounters *counters = page->counters[mutexId % PROFILE_PAGE_SIZE].load(std::memory_order_acquire);
+			if (counters == NULL)
+				continue;
+
+			used = true;
+			profile->acquisitions += counters->acquisitions.load(std::memory_order_relaxed);
+			profile->contentions += counters->contentions.load(std::memory_order_relaxed);
+			profile->donations += counters->donations.load(std::memory_order_relaxed);
+			for (int i = 0; i < PROFILE_BUCKETS; i++)
+			{
+				profile->hold[i] += counters->hold[i].load(std::memory_order_relaxed);
+				profile->wait[i] += counters->wait[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		return used;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns highest profiled mutex id.
+	//-----------------------------------------------------------------------------------------
+	int Profile::getMaxMutexId()
+	{
+		return maxMutexId.load();
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Prints one line per profiled mutex (times in nanoseconds).
+	//-----------------------------------------------------------------------------------------
+	void Profile::dump(FILE* file)
+	{
+		fprintf(file, "\nmutex statistics (times in ns)\n");
+		fprintf(file, "%-7s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n", "mutex", "acquired",
+				"contended", "donations", "hold p50", "hold p99", "hold max", "wait p50", "wait p99", "wait max");
+
+		MutexProfile *profile = new MutexProfile;
+		for (int id = 0; id <= getMaxMutexId(); id++)
+		{
+			if (!collect(id, profile))
+				continue;
+
+			fprintf(file, "CS%-5d %10llu %10llu %10llu %10llu %10llu %10llu %10llu %10llu %10llu\n", id,
+					(unsigned long long) profile->acquisitions, (unsigned long long) profile->contentions,
+					(unsigned long long) profile->donations,
+					(unsigned long long) percentile(profile->hold, 50),
+					(unsigned long long) percentile(profile->hold, 99),
+					(unsigned long long) percentile(profile->hold, 100),
+					(unsigned long long) percentile(profile->wait, 50),
+					(unsigned long long) percentile(profile->wait, 99),
+					(unsigned long long) percentile(profile->wait, 100));
+		}
+		delete profile;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns bucket of value: exact below 2^(SUB_BITS+1), then 2^SUB_BITS buckets per
+	// power of two (the top SUB_BITS+1 significant bits of the value).
+	//-----------------------------------------------------------------------------------------
+	int Profile::bucket(uint64_t value)
+	{
+		if (value < (1ULL << (PROFILE_SUB_BITS + 1)))
+			return (int) value;
+
+		int shift = 63 - __builtin_clzll(value) - PROFILE_SUB_BITS;
+		return (shift << PROFILE_SUB_BITS) + (int) (value >> shift);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns lowest value of bucket (inverse of bucket()).
+	//-----------------------------------------------------------------------------------------
+	uint64_t Profile::bucketValue(int bucket)
+	{
+		if (bucket < (1 << (PROFILE_SUB_BITS + 1)))
+			return bucket;
+
+		int shift = (bucket >> PROFILE_SUB_BITS) - 1;
+		return (uint64_t) (bucket - (shift << PROFILE_SUB_BITS)) << shift;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns the p-th percentile of histogram.
+	//-----------------------------------------------------------------------------------------
+	uint64_t Profile::percentile(const uint64_t histogram[], double p)
+	{
+		uint64_t total = 0;
+		for (int i = 0; i < PROFILE_BUCKETS; i++)
+			total += histogram[i];
+		if (total == 0)
+			return 0;
+
+		uint64_t rank = (uint64_t) (p / 100.0 * total + 0.5);
+		if (rank < 1)
+			rank = 1;
+
+		uint64_t count = 0;
+		for (int i = 0; i < PROFILE_BUCKETS; i++)
+		{
+			count += histogram[i];
+			if (count >= rank)
+				return bucketValue(i);
+		}
+
+		return bucketValue(PROFILE_BUCKETS - 1);
+	}
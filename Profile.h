@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef Profile_h
+#define Profile_h
+
+// histogram precision: 2^PROFILE_SUB_BITS buckets per power of two (25% relative error)
+#define PROFILE_SUB_BITS 2
+
+// number of histogram buckets (covers the whole 64-bit range)
+#define PROFILE_BUCKETS ((65 - PROFILE_SUB_BITS) << PROFILE_SUB_BITS)
+
+// profiled mutex ids (0 .. PROFILE_MAX_MUTEXES-1), same range as trace events
+#define PROFILE_MAX_MUTEXES 65536
+
+//-----------------------------------------------------------------------------------------
+// Merged statistics of one mutex. Histograms count nanoseconds in log-scaled buckets
+// (see Profile::bucket), wait time is 0 for acquisitions without contention.
+//-----------------------------------------------------------------------------------------
+struct MutexProfile
+{
+	uint64_t acquisitions;			// successful locks
+	uint64_t contentions;			// locks that had to wait (counted once per wait)
+	uint64_t donations;				// priority transfers to the owner
+	uint64_t hold[PROFILE_BUCKETS];	// lock to unlock
+	uint64_t wait[PROFILE_BUCKETS];	// first attempt to successful lock
+};
+
+//-----------------------------------------------------------------------------------------
+// Profile class definition.
+// Mutex contention profiler. Every thread counts into its own tables (no shared writes
+// on the locking path), collect merges the tables of all threads on demand. Pending waits
+// are kept per task (thread id of the simulator), as coroutine jobs share one OS thread.
+// The hooks return immediately while profiling is stopped.
+//-----------------------------------------------------------------------------------------
+class Profile
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		// starts profiling
+		static void start();
+
+		// stops profiling (collected data is kept)
+		static void stop();
+
+		// mutex acquired by thread: counts it, ends its pending wait, returns hold start time (ns)
+		static long long acquired(int mutexId, int threadId);
+
+		// lock attempt of thread has to wait: starts a wait (once until acquired)
+		static void contended(int mutexId, int threadId);
+
+		// priority donated to the owner of mutex
+		static void donated(int mutexId);
+
+		// mutex released: records hold time since holdStart (returned by acquired)
+		static void released(int mutexId, long long holdStart);
+
+		// merges statistics of all threads, returns false if the mutex was never used
+		static bool collect(int mutexId, MutexProfile* profile);
+
+		// returns highest profiled mutex id (-1 if none)
+		static int getMaxMutexId();
+
+		// prints a statistics table of all profiled mutexes
+		static void dump(FILE* file);
+
+		// returns histogram bucket of value
+		static int bucket(uint64_t value);
+
+		// returns lowest value of histogram bucket
+		static uint64_t bucketValue(int bucket);
+
+		// returns p-th percentile (0 < p <= 100) of histogram (bucket lowest value)
+		static uint64_t percentile(const uint64_t histogram[], double p);
+};
+
+//-----------------------------------------------------------------------------------------
+// Hold time of one mutex (member of every profiled mutex). acquired starts it, released
+// records it. The start is cleared on release, before another owner can lock the mutex
+// and overwrite it. 0 = not profiled (profiling was stopped when the mutex was locked).
+//-----------------------------------------------------------------------------------------
+class ProfileHold
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		ProfileHold()
+		{
+			start = 0;
+		}
+
+		// mutex acquired by thread (see Profile::acquired)
+		void acquired(int mutexId, int threadId)
+		{
+			start = Profile::acquired(mutexId, threadId);
+		}
+
+		// mutex released, records the hold time (see Profile::released)
+		void released(int mutexId)
+		{
+			Profile::released(mutexId, start);
+			start = 0;
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		long long start;
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <errno.h>
+
+#include "Deadlock.h"
+#include "History.h"
+#include "Mutex.h"
+#include "PcMutex.h"
+#include "PiMutex.h"
+#include "Profile.h"
+#include "ReadyQueue.h"
+#include "SrpMutex.h"
+#include "Trace.h"
+
+#ifndef ProtocolMutex_h
+#define ProtocolMutex_h
+
+//-----------------------------------------------------------------------------------------
+// NoProtocol policy: plain Mutex, priorities are never changed (unbounded inversion).
+// A thread that finds the mutex locked is suspended until unlock (then retries).
+//-----------------------------------------------------------------------------------------
+class NoProtocol
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Constructor
+		//-----------------------------------------------------------------------------------------
+		NoProtocol()
+		{
+			owner = 0;
+			mutexId = 0;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Locks mutex, suspends the thread if it is locked. Returns 0 (success) or error code.
+		//-----------------------------------------------------------------------------------------
+		int lock(int threadId, ReadyQueue* queue)
+		{
+			int lockStatus = mutex.trylock();
+			if (lockStatus == 0)
+			{
+				Trace::record(TRACE_NP_LOCKING, threadId, mutexId, 0, 0);
+				hold.acquired(mutexId, threadId);
+				owner = threadId;
+				return lockStatus;
+			}
+
+			Profile::contended(mutexId, threadId);
+			Trace::record(TRACE_NP_SUSPEND, threadId, mutexId, 0, 0);
+			waiters.push_front(threadId);
+			queue->suspend(threadId);
+			Deadlock::blocked(threadId, mutexId, owner);
+			return lockStatus;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Unlocks mutex and resumes suspended threads.
+		//-----------------------------------------------------------------------------------------
+		int unlock(int threadId, ReadyQueue* queue)
+		{
+			hold.released(mutexId);
+
+			int unlockStatus = mutex.unlock();
+			if (unlockStatus != 0)
+				return unlockStatus;
+
+			Trace::record(TRACE_NP_UNLOCKED, threadId, mutexId, 0, 0);
+			while (!waiters.empty())
+			{
+				queue->resume(waiters.front());
+				Deadlock::unblocked(waiters.front());
+				waiters.pop_front();
+			}
+
+			return unlockStatus;
+		}
+
+		// ceiling protocols only
+		void setCsPriority(int) {}
+		void setImmediate(bool) {}
+		static void released(int, int, ReadyQueue*) {}
+
+		void setId(int id) { mutexId = id; }
+		int getId() { return mutexId; }
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		Mutex mutex;
+		History<int> waiters;		// suspended threads
+		int owner;
+		int mutexId;
+		ProfileHold hold;
+};
+
+//-----------------------------------------------------------------------------------------
+// InheritancePolicy: transitive priority inheritance (PiMutex).
+//-----------------------------------------------------------------------------------------
+class InheritancePolicy
+{
+	public:
+		int lock(int threadId, ReadyQueue* queue) { return mutex.lock(threadId, queue); }
+		int unlock(int threadId, ReadyQueue* queue) { return mutex.unlock(threadId, queue); }
+
+		// ceiling protocols only
+		void setCsPriority(int) {}
+		void setImmediate(bool) {}
+		static void released(int, int, ReadyQueue*) {}
+
+		void setId(int id) { mutex.setId(id); }
+		int getId() { return mutex.getId(); }
+
+	private:
+		PiMutex mutex;
+};
+
+//-----------------------------------------------------------------------------------------
+// CeilingPolicy: original priority ceiling protocol (PcMutex), immediate per mutex.
+//-----------------------------------------------------------------------------------------
+class CeilingPolicy
+{
+	public:
+		int lock(int threadId, ReadyQueue* queue) { return mutex.lock(threadId, queue); }
+		int unlock(int, ReadyQueue* queue) { return mutex.unlock(queue); }
+
+		void setCsPriority(int priority) { mutex.setCsPriority(priority); }
+		void setImmediate(bool enable) { mutex.setImmediate(enable); }
+		static void released(int, int, ReadyQueue*) {}
+
+		void setId(int id) { mutex.setId(id); }
+		int getId() { return mutex.getId(); }
+
+	protected:
+		PcMutex mutex;
+};
+
+//-----------------------------------------------------------------------------------------
+// ImmediateCeilingPolicy: immediate (highest locker) priority ceiling protocol (PcMutex).
+//-----------------------------------------------------------------------------------------
+class ImmediateCeilingPolicy : public CeilingPolicy
+{
+	public:
+		ImmediateCeilingPolicy() { mutex.setImmediate(true); }
+
+		// always immediate
+		void setImmediate(bool) {}
+};
+
+//-----------------------------------------------------------------------------------------
+// SrpPolicy: stack resource policy (SrpMutex), jobs are admitted at release.
+//-----------------------------------------------------------------------------------------
+class SrpPolicy
+{
+	public:
+		int lock(int threadId, ReadyQueue*) { return mutex.lock(threadId); }
+		int unlock(int threadId, ReadyQueue* queue) { return mutex.unlock(threadId, queue); }
+
+		void setCsPriority(int priority) { mutex.setCsPriority(priority); }
+		void setImmediate(bool) {}
+		static void released(int threadId, int priority, ReadyQueue* queue)
+		{
+			SrpMutex::admit(threadId, priority, queue);
+		}
+
+		void setId(int id) { mutex.setId(id); }
+		int getId() { return mutex.getId(); }
+
+	private:
+		SrpMutex mutex;
+};
+
+//-----------------------------------------------------------------------------------------
+// ProtocolMutex class template definition and implementation.
+// One resource access protocol selected at compile time by Policy (NoProtocol,
+// InheritancePolicy, CeilingPolicy, ImmediateCeilingPolicy, SrpPolicy). All policies
+// share the same API, there are no virtual functions, so lock and unlock inline down to
+// the protocol code. Emulated protocols only (priorities in the simulator's ReadyQueue).
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+class ProtocolMutex
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Locks mutex, a thread that must wait is suspended in queue and retries after unlock.
+		// Returns 0 (success) or error code (not acquired).
+		//-----------------------------------------------------------------------------------------
+		int lock(int threadId, ReadyQueue* queue)
+		{
+			return policy.lock(threadId, queue);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Unlocks mutex held by threadId. Returns 0 (success) or error code (failure).
+		//-----------------------------------------------------------------------------------------
+		int unlock(int threadId, ReadyQueue* queue)
+		{
+			return policy.unlock(threadId, queue);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Sets critical section priority (ceiling protocols, ignored by the others).
+		//-----------------------------------------------------------------------------------------
+		void setCsPriority(int priority)
+		{
+			policy.setCsPriority(priority);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Selects the immediate ceiling for this mutex (CeilingPolicy, ignored by the others).
+		//-----------------------------------------------------------------------------------------
+		void setImmediate(bool enable)
+		{
+			policy.setImmediate(enable);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Job of thread released with base priority (SRP admission, no-op for the others).
+		//-----------------------------------------------------------------------------------------
+		static void released(int threadId, int priority, ReadyQueue* queue)
+		{
+			Policy::released(threadId, priority, queue);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Sets mutex id.
+		//-----------------------------------------------------------------------------------------
+		void setId(int id)
+		{
+			policy.setId(id);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns mutex id.
+		//-----------------------------------------------------------------------------------------
+		int getId()
+		{
+			return policy.getId();
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		Policy policy;
+};
+
+#endif
@@ -2,7 +2,7 @@
 #include "PulseTimer.h"
 
 //---------------------------------------------------------------------------------------------
-// Periodic PulseTimer class implementation.
+// Periodic PulseTimer class implementation (backend independent part).
 //---------------------------------------------------------------------------------------------
 
 	//-----------------------------------------------------------------------------------------
@@ -10,7 +10,7 @@
 	//-----------------------------------------------------------------------------------------
 	PulseTimer::PulseTimer(double interval)
 	{
-		printf("Creating and initializing PulseTimer ...\n");
+		Log<LOG_INFO>::print("Creating and initializing PulseTimer ...\n");
 
 		// create and set channel id
 		setChannelId(createChannel());
@@ -28,136 +28,14 @@
 	}
 
 	//-----------------------------------------------------------------------------------------
-	// Destroys timer object.
-	// 1. Detaches previously attached timer by specified connectionId (if not already detached).
-	// 2. Removes it from the  timer_create() function by specified timerId.
-	// (the timer is moved from  the active system timer list to the free list of available timers.)
-	// 3. Destroys channel if not already destroyed
-	//-----------------------------------------------------------------------------------------
-	PulseTimer::~PulseTimer()
-	{
-		printf("\n\nDestroying PulseTimer ...\n");
-
-		// detaches the connection
-		if (ConnectDetach(getConnectionId()) < 0)
-			printf("Error detaching connection \n");
-
-		// 0 <=> success, -1 <=> failure
-		if (timer_delete(timerId) != 0)
-			printf("Error removing timer \n");
-
-		int chId = getChannelId();
-		if (chId != -1)
-			ChannelDestroy(chId);
-	}
-
-	//-----------------------------------------------------------------------------------------
-	// Connects client (pulse timer) to the server (corresponding thread).
-	// Establishes a connection between the calling process and the channel specified by chId.
-	//-----------------------------------------------------------------------------------------
-	void PulseTimer::connectionAttach(int chId)
-	{
-		int connectId = ConnectAttach(0, 0, chId, 0, 0);
-		if (connectId == -1)
-		{
-			printf("Error attaching connection \n");
-			setDetached(true);
-			exit(EXIT_FAILURE);
-		}
-		else
-		{
-			printf("Connection attached successfully \n");
-			setConnectionId(connectId);
-			setDetached(false);
-		}
-	}
-
-	//-----------------------------------------------------------------------------------------
-	// Converts specified time interval into seconds and nanoseconds
+	// Converts specified time interval into seconds and nanoseconds.
+	// Rounds to the nearest nanosecond once, so sub-millisecond periods are exact.
 	//-----------------------------------------------------------------------------------------
 	void PulseTimer::setInterval(double interval)
 	{
-		seconds = floor(interval);
-		nanoseconds = (interval - seconds)*pow(10,9);
-	}
-
-	//-----------------------------------------------------------------------------------------
-	// Initializes notification.
-	// Creates timer object within the kernel and initializes timerId (returns reference to timerId)
-	//-----------------------------------------------------------------------------------------
-	void PulseTimer::createTimer()
-	{
-		SIGEV_PULSE_INIT(&event, getConnectionId(), SIGEV_PULSE_PRIO_INHERIT, PULSE_FROM_TIMER, NULL);
-
-		int timer = timer_create(CLOCK_REALTIME, &event, &timerId);
-		if (timer == -1)
-		{
-			printf("Timer creation error \n");
-			exit(EXIT_FAILURE);
-		}
-		else
-			printf("Timer created successfully \n");
-	}
-
-	//-----------------------------------------------------------------------------------------
-	// Starts timer and updates its running status.
-	//-----------------------------------------------------------------------------------------
-	int PulseTimer::start()
-	{
-		// (re)initializes timer structure
-		reset();
-
-		// start the timer and running status accordingly
-		int result = timer_settime(timerId, 0, &timer, NULL);
-		if (result != 0)
-		{
-			printf("Error creating timer \n");
-			exit(EXIT_FAILURE);
-		}
-		else
-		{
-			this->setRunning(true);
-			printf("Timer started \n");
-		}
-
-		return result;
-	}
-
-	//-----------------------------------------------------------------------------------------
-	// Stops timer by nullifying its timer values and updating active system timer.
-	//-----------------------------------------------------------------------------------------
-	int PulseTimer::stop()
-	{
-		timer.it_value.tv_sec = 0;
-		timer.it_value.tv_nsec = 0;
-		timer.it_interval.tv_sec = 0;
-		timer.it_interval.tv_nsec = 0;
-
-		int result = timer_settime(timerId, 0, &timer, NULL);
-		if (result == 0)
-			this->setRunning(false);
-		else
-			printf("Error stopping timer \n");
-
-		return result;
-	}
-
-	//-----------------------------------------------------------------------------------------
-	// Blocks on MsgReceivePulse call until the pulse is received from the timer.
-	//-----------------------------------------------------------------------------------------
-	void PulseTimer::wait()
-	{
-		// dummy buffer
-		string buffer[8];
-
-		// wait for the pulse to fire
-		int receivedPulse = MsgReceivePulse(getChannelId(), &buffer, sizeof(buffer), NULL);
-
-		if (receivedPulse != 0)
-		{
-			printf("Error receiving timer pulse\n");
-			exit(EXIT_FAILURE);
-		}
+		long long total = llround(interval * NANOSECONDS_PER_SECOND);
+		seconds = total / NANOSECONDS_PER_SECOND;
+		nanoseconds = total % NANOSECONDS_PER_SECOND;
 	}
 
 	//-----------------------------------------------------------------------------------------
@@ -165,29 +43,13 @@
 	//-----------------------------------------------------------------------------------------
 	void PulseTimer::reset()
 	{
-		// periodic timer: will go off in 1 sec and then again every sec+nanosec
-		timer.it_value.tv_sec = 1;
-		timer.it_value.tv_nsec = 0;
+		// periodic timer: will go off in one interval and then again every sec+nanosec
+		timer.it_value.tv_sec = getSeconds();
+		timer.it_value.tv_nsec = getNanoseconds();
 		timer.it_interval.tv_sec = getSeconds();
 		timer.it_interval.tv_nsec = getNanoseconds();
 	}
 
-	//-----------------------------------------------------------------------------------------
-	// Detaches the connection specified by the connectionId.
-	// If any threads are blocked on the connection at the time the connection is detached,
-	// the send fails and returns with an error (see QNX doc for ConnectDetach()).
-	//-----------------------------------------------------------------------------------------
-	int PulseTimer::detach()
-	{
-		int result = ConnectDetach(getConnectionId());
-		if (result == 0)
-			this->setDetached(true);
-		else
-			printf("Error detaching connection \n");
-
-		return result;
-	}
-
 	//-----------------------------------------------------------------------------------------
 	// Returns timer id for display or logging purposes.
 	//-----------------------------------------------------------------------------------------
@@ -275,20 +137,3 @@
 	{
 		channelId = chId;
 	}
-
-	//-----------------------------------------------------------------------------------------
-	// Creates a channel that can receive messages and pulses.
-	// ConnectAttach() should be called from the target object in order to establish a connection.
-	//-----------------------------------------------------------------------------------------
-	int PulseTimer::createChannel()
-	{
-		// disable priority inheritance with _NTO_CHF_FIXED_PRIORITY option
-		int chId = ChannelCreate(_NTO_CHF_FIXED_PRIORITY);
-		if (chId == -1)
-				printf("Error creating channel \n");
-		else
-			// for debugging purposes only
-			printf("Channel successfully created \n");
-
-		return chId;
-	}
@@ -1,20 +1,37 @@
 #include <cstdlib>
-#include <iostream.h>
+#include <stdio.h>
 #include <time.h>
+
+#ifdef __QNX__
+#include <iostream.h>
 #include <sys/siginfo.h>
 #include <sys/neutrino.h>
+#else
+#include <iostream>
+#include <sys/timerfd.h>
+#endif
 
 // include -lmath linker option at compile time to avoid "undefined reference" error
 #include <math.h>
 
+#include "Log.h"
+
 #ifndef pulsetimer_h
 #define pulsetimer_h
 
 // pulse from timer (check the pulse's code value upon message receipt)
 #define PULSE_FROM_TIMER 1
 
+// nanoseconds in one second
+#define NANOSECONDS_PER_SECOND 1000000000L
+
 //-----------------------------------------------------------------------------------------
 // PulseTimer interface.
+// The backend is selected at compile time:
+//  - PulseTimerQnx.cc: QNX channel/connection receiving kernel timer pulses;
+//  - PulseTimerLinux.cc: timerfd armed with absolute CLOCK_MONOTONIC deadlines.
+// Both backends are periodic kernel timers anchored to the start time (no cumulative drift),
+// startAt arms a single expiry instead (tickless operation).
 //-----------------------------------------------------------------------------------------
 class PulseTimer
 {
@@ -32,11 +49,14 @@ class PulseTimer
 		// starts timer
 		int start();
 
+		// starts timer as one-shot, expiring at an absolute CLOCK_MONOTONIC time
+		int startAt(const struct timespec* expiry);
+
 		// stops timer
 		int stop();
 
-		// waits for the pulse to fire
-		void wait();
+		// waits for the pulse to fire, returns the number of missed ticks (overruns)
+		int wait();
 
 		// (re)initializes the guts of the timer structure
 		void reset();
@@ -72,7 +92,9 @@ class PulseTimer
 
 		timer_t timerId;
 		struct itimerspec timer;
+#ifdef __QNX__
 		struct sigevent event;
+#endif
 		int connectionId;
 		int channelId;
 
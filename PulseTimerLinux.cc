@@ -0,0 +1,174 @@
+
+#include "PulseTimer.h"
+
+#ifndef __QNX__
+
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+
+//---------------------------------------------------------------------------------------------
+// PulseTimer Linux backend: timerfd on CLOCK_MONOTONIC.
+// The channel is the timerfd descriptor, a pulse is a readable expiration count.
+// The first deadline is absolute (start time + interval), subsequent expirations are
+// computed by the kernel from that anchor, so the period does not accumulate drift.
+//---------------------------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------------------
+	// Destroys timer object.
+	// Disarms the timer and closes the timerfd (the "channel").
+	//-----------------------------------------------------------------------------------------
+	PulseTimer::~PulseTimer()
+	{
+		Log<LOG_INFO>::print("\n\nDestroying PulseTimer ...\n");
+
+		int chId = getChannelId();
+		if (chId != -1 && close(chId) != 0)
+			Log<LOG_ERROR>::print("Error removing timer \n");
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// There is no separate connection on Linux, the timer fires directly on the timerfd.
+	//-----------------------------------------------------------------------------------------
+	void PulseTimer::connectionAttach(int chId)
+	{
+		if (chId == -1)
+		{
+			Log<LOG_ERROR>::print("Error attaching connection \n");
+			setDetached(true);
+			exit(EXIT_FAILURE);
+		}
+
+		setConnectionId(chId);
+		setDetached(false);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// The kernel timer is the timerfd itself (created with the channel).
+	//-----------------------------------------------------------------------------------------
+	void PulseTimer::createTimer()
+	{
+		timerId = 0;
+		Log<LOG_DEBUG>::print("Timer created successfully \n");
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Starts timer and updates its running status.
+	// Converts the relative first expiry into an absolute CLOCK_MONOTONIC deadline.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::start()
+	{
+		// (re)initializes timer structure
+		reset();
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		timer.it_value.tv_sec += now.tv_sec;
+		timer.it_value.tv_nsec += now.tv_nsec;
+		if (timer.it_value.tv_nsec >= NANOSECONDS_PER_SECOND)
+		{
+			timer.it_value.tv_sec++;
+			timer.it_value.tv_nsec -= NANOSECONDS_PER_SECOND;
+		}
+
+		int result = timerfd_settime(getChannelId(), TFD_TIMER_ABSTIME, &timer, NULL);
+		if (result != 0)
+		{
+			Log<LOG_ERROR>::print("Error creating timer \n");
+			exit(EXIT_FAILURE);
+		}
+		else
+		{
+			this->setRunning(true);
+			Log<LOG_INFO>::print("Timer started \n");
+		}
+
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Arms the timerfd for a single absolute expiry (a past expiry fires immediately).
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::startAt(const struct timespec* expiry)
+	{
+		timer.it_value = *expiry;
+		timer.it_interval.tv_sec = 0;
+		timer.it_interval.tv_nsec = 0;
+
+		int result = timerfd_settime(getChannelId(), TFD_TIMER_ABSTIME, &timer, NULL);
+		if (result != 0)
+		{
+			Log<LOG_ERROR>::print("Error arming timer \n");
+			exit(EXIT_FAILURE);
+		}
+
+		this->setRunning(true);
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Stops timer by nullifying its timer values (disarms the timerfd).
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::stop()
+	{
+		timer.it_value.tv_sec = 0;
+		timer.it_value.tv_nsec = 0;
+		timer.it_interval.tv_sec = 0;
+		timer.it_interval.tv_nsec = 0;
+
+		int result = timerfd_settime(getChannelId(), 0, &timer, NULL);
+		if (result == 0)
+			this->setRunning(false);
+		else
+			Log<LOG_ERROR>::print("Error stopping timer \n");
+
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Blocks on the timerfd until at least one expiration occurred.
+	// Returns the number of expirations missed since the previous wait.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::wait()
+	{
+		uint64_t expirations = 0;
+
+		ssize_t size;
+		do
+			size = read(getChannelId(), &expirations, sizeof(expirations));
+		while (size == -1 && errno == EINTR);
+
+		if (size != sizeof(expirations))
+		{
+			Log<LOG_ERROR>::print("Error receiving timer pulse\n");
+			exit(EXIT_FAILURE);
+		}
+
+		return (int) (expirations - 1);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Nothing to detach from on Linux, only updates the detached status.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::detach()
+	{
+		this->setDetached(true);
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Creates the timerfd that receives timer expirations.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::createChannel()
+	{
+		int chId = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+		if (chId == -1)
+			Log<LOG_ERROR>::print("Error creating channel \n");
+		else
+			// for debugging purposes only
+			Log<LOG_DEBUG>::print("Channel successfully created \n");
+
+		return chId;
+	}
+
+#endif
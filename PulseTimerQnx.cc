@@ -0,0 +1,192 @@
+
+#include "PulseTimer.h"
+
+#ifdef __QNX__
+
+//---------------------------------------------------------------------------------------------
+// PulseTimer QNX backend: kernel timer delivering pulses to a channel.
+//---------------------------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------------------
+	// Destroys timer object.
+	// 1. Detaches previously attached timer by specified connectionId (if not already detached).
+	// 2. Removes it from the  timer_create() function by specified timerId.
+	// (the timer is moved from  the active system timer list to the free list of available timers.)
+	// 3. Destroys channel if not already destroyed
+	//-----------------------------------------------------------------------------------------
+	PulseTimer::~PulseTimer()
+	{
+		Log<LOG_INFO>::print("\n\nDestroying PulseTimer ...\n");
+
+		// detaches the connection
+		if (ConnectDetach(getConnectionId()) < 0)
+			Log<LOG_ERROR>::print("Error detaching connection \n");
+
+		// 0 <=> success, -1 <=> failure
+		if (timer_delete(timerId) != 0)
+			Log<LOG_ERROR>::print("Error removing timer \n");
+
+		int chId = getChannelId();
+		if (chId != -1)
+			ChannelDestroy(chId);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Connects client (pulse timer) to the server (corresponding thread).
+	// Establishes a connection between the calling process and the channel specified by chId.
+	//-----------------------------------------------------------------------------------------
+	void PulseTimer::connectionAttach(int chId)
+	{
+		int connectId = ConnectAttach(0, 0, chId, 0, 0);
+		if (connectId == -1)
+		{
+			Log<LOG_ERROR>::print("Error attaching connection \n");
+			setDetached(true);
+			exit(EXIT_FAILURE);
+		}
+		else
+		{
+			Log<LOG_DEBUG>::print("Connection attached successfully \n");
+			setConnectionId(connectId);
+			setDetached(false);
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Initializes notification.
+	// Creates timer object within the kernel and initializes timerId (returns reference to timerId)
+	//-----------------------------------------------------------------------------------------
+	void PulseTimer::createTimer()
+	{
+		SIGEV_PULSE_INIT(&event, getConnectionId(), SIGEV_PULSE_PRIO_INHERIT, PULSE_FROM_TIMER, NULL);
+
+		int timer = timer_create(CLOCK_MONOTONIC, &event, &timerId);
+		if (timer == -1)
+		{
+			Log<LOG_ERROR>::print("Timer creation error \n");
+			exit(EXIT_FAILURE);
+		}
+		else
+			Log<LOG_DEBUG>::print("Timer created successfully \n");
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Starts timer and updates its running status.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::start()
+	{
+		// (re)initializes timer structure
+		reset();
+
+		// start the timer and running status accordingly
+		int result = timer_settime(timerId, 0, &timer, NULL);
+		if (result != 0)
+		{
+			Log<LOG_ERROR>::print("Error creating timer \n");
+			exit(EXIT_FAILURE);
+		}
+		else
+		{
+			this->setRunning(true);
+			Log<LOG_INFO>::print("Timer started \n");
+		}
+
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Arms the kernel timer for a single absolute expiry (a past expiry fires immediately).
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::startAt(const struct timespec* expiry)
+	{
+		timer.it_value = *expiry;
+		timer.it_interval.tv_sec = 0;
+		timer.it_interval.tv_nsec = 0;
+
+		int result = timer_settime(timerId, TIMER_ABSTIME, &timer, NULL);
+		if (result != 0)
+		{
+			Log<LOG_ERROR>::print("Error arming timer \n");
+			exit(EXIT_FAILURE);
+		}
+
+		this->setRunning(true);
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Stops timer by nullifying its timer values and updating active system timer.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::stop()
+	{
+		timer.it_value.tv_sec = 0;
+		timer.it_value.tv_nsec = 0;
+		timer.it_interval.tv_sec = 0;
+		timer.it_interval.tv_nsec = 0;
+
+		int result = timer_settime(timerId, 0, &timer, NULL);
+		if (result == 0)
+			this->setRunning(false);
+		else
+			Log<LOG_ERROR>::print("Error stopping timer \n");
+
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Blocks on MsgReceivePulse call until the pulse is received from the timer.
+	// Returns the number of expirations missed since the previous pulse.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::wait()
+	{
+		// dummy buffer
+		string buffer[8];
+
+		// wait for the pulse to fire
+		int receivedPulse = MsgReceivePulse(getChannelId(), &buffer, sizeof(buffer), NULL);
+
+		if (receivedPulse != 0)
+		{
+			Log<LOG_ERROR>::print("Error receiving timer pulse\n");
+			exit(EXIT_FAILURE);
+		}
+
+		int overruns = timer_getoverrun(timerId);
+		return (overruns > 0) ? overruns : 0;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Detaches the connection specified by the connectionId.
+	// If any threads are blocked on the connection at the time the connection is detached,
+	// the send fails and returns with an error (see QNX doc for ConnectDetach()).
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::detach()
+	{
+		int result = ConnectDetach(getConnectionId());
+		if (result == 0)
+			this->setDetached(true);
+		else
+			Log<LOG_ERROR>::print("Error detaching connection \n");
+
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Creates a channel that can receive messages and pulses.
+	// ConnectAttach() should be called from the target object in order to establish a connection.
+	//-----------------------------------------------------------------------------------------
+	int PulseTimer::createChannel()
+	{
+		// disable priority inheritance with _NTO_CHF_FIXED_PRIORITY option
+		int chId = ChannelCreate(_NTO_CHF_FIXED_PRIORITY);
+		if (chId == -1)
+				Log<LOG_ERROR>::print("Error creating channel \n");
+		else
+			// for debugging purposes only
+			Log<LOG_DEBUG>::print("Channel successfully created \n");
+
+		return chId;
+	}
+
+
+#endif
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <sched.h>
+
+#ifndef ReadyQueue_h
+#define ReadyQueue_h
+
+#define PRIORITY_LEVELS 256		// integer priority levels (0 = lowest, 255 = highest)
+#define PRIORITY_WORDS (PRIORITY_LEVELS / 64)
+#define NO_TASK 0				// task ids start at 1, 0 means "no task"
+
+//-----------------------------------------------------------------------------------------
+// Maps a priority level to a SCHED_FIFO priority (scaled, keeps the order of levels).
+//-----------------------------------------------------------------------------------------
+inline int nativePriority(int priority)
+{
+	int min = sched_get_priority_min(SCHED_FIFO);
+	int max = sched_get_priority_max(SCHED_FIFO);
+	return min + priority * (max - min) / (PRIORITY_LEVELS - 1);
+}
+
+//-----------------------------------------------------------------------------------------
+// ReadyQueue class definition and implementation.
+// Keeps released tasks in per-priority FIFO lists and a two-level bitmap of non-empty
+// levels, so the highest priority ready task is found in O(1) with count-leading-zeros.
+// Suspended (blocked) tasks keep their priority, but are taken out of the lists.
+// Not thread safe, callers serialize access (CPU mutex).
+//-----------------------------------------------------------------------------------------
+class ReadyQueue
+{
+	//-----------------------------------------------------------------------------------------
+	// Task state
+	//-----------------------------------------------------------------------------------------
+	enum TaskState
+	{
+		IDLE,		// not released or completed
+		READY,		// queued at its priority level
+		SUSPENDED	// released, but blocked
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Constructor (task ids from 1 to capacity-1)
+		//-----------------------------------------------------------------------------------------
+		ReadyQueue(int capacity)
+		{
+			size = capacity;
+			priority = new int[size];
+			state = new TaskState[size];
+			next = new int[size];
+			prev = new int[size];
+			for (int i = 0; i < size; i++)
+			{
+				priority[i] = 0;
+				state[i] = IDLE;
+				next[i] = prev[i] = NO_TASK;
+			}
+
+			for (int i = 0; i < PRIORITY_LEVELS; i++)
+				head[i] = tail[i] = NO_TASK;
+
+			summary = 0;
+			for (int i = 0; i < PRIORITY_WORDS; i++)
+				bitmap[i] = 0;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Destructor
+		//-----------------------------------------------------------------------------------------
+		~ReadyQueue()
+		{
+			delete[] priority;
+			delete[] state;
+			delete[] next;
+			delete[] prev;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Releases task with specified priority (appended to its level).
+		//-----------------------------------------------------------------------------------------
+		void insert(int taskId, int taskPriority)
+		{
+			priority[taskId] = taskPriority;
+			state[taskId] = READY;
+			enqueue(taskId);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Removes completed task.
+		//-----------------------------------------------------------------------------------------
+		void remove(int taskId)
+		{
+			if (state[taskId] == READY)
+				dequeue(taskId);
+			state[taskId] = IDLE;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Changes task priority, a ready task moves to the tail of the new level. An unchanged
+		// priority keeps the task's place among the tasks of its level.
+		//-----------------------------------------------------------------------------------------
+		void setPriority(int taskId, int taskPriority)
+		{
+			if (priority[taskId] == taskPriority)
+				return;
+
+			if (state[taskId] == READY)
+			{
+				dequeue(taskId);
+				priority[taskId] = taskPriority;
+				enqueue(taskId);
+			}
+			else
+				priority[taskId] = taskPriority;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns task's current priority.
+		//-----------------------------------------------------------------------------------------
+		int getPriority(int taskId)
+		{
+			return priority[taskId];
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Suspends (blocks) ready task.
+		//-----------------------------------------------------------------------------------------
+		void suspend(int taskId)
+		{
+			if (state[taskId] == READY)
+			{
+				dequeue(taskId);
+				state[taskId] = SUSPENDED;
+			}
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Resumes suspended task (appended to its level).
+		//-----------------------------------------------------------------------------------------
+		void resume(int taskId)
+		{
+			if (state[taskId] == SUSPENDED)
+			{
+				state[taskId] = READY;
+				enqueue(taskId);
+			}
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns true if task is released, but suspended.
+		//-----------------------------------------------------------------------------------------
+		bool isSuspended(int taskId)
+		{
+			return state[taskId] == SUSPENDED;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns true if task is queued.
+		//-----------------------------------------------------------------------------------------
+		bool isReady(int taskId)
+		{
+			return state[taskId] == READY;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the first task of the highest non-empty level, or NO_TASK.
+		//-----------------------------------------------------------------------------------------
+		int top()
+		{
+			if (summary == 0)
+				return NO_TASK;
+
+			int word = 63 - __builtin_clzll(summary);
+			int bit = 63 - __builtin_clzll(bitmap[word]);
+
+			return head[word * 64 + bit];
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		//-----------------------------------------------------------------------------------------
+		// Appends task to the tail of its level and marks the level as non-empty.
+		//-----------------------------------------------------------------------------------------
+		void enqueue(int taskId)
+		{
+			int level = priority[taskId];
+
+			next[taskId] = NO_TASK;
+			prev[taskId] = tail[level];
+			if (tail[level] == NO_TASK)
+				head[level] = taskId;
+			else
+				next[tail[level]] = taskId;
+			tail[level] = taskId;
+
+			bitmap[level / 64] |= 1ULL << (level % 64);
+			summary |= 1ULL << (level / 64);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Unlinks task from its level, clears the level bit if it became empty.
+		//-----------------------------------------------------------------------------------------
+		void dequeue(int taskId)
+		{
+			int level = priority[taskId];
+
+			if (prev[taskId] == NO_TASK)
+				head[level] = next[taskId];
+			else
+				next[prev[taskId]] = next[taskId];
+
+			if (next[taskId] == NO_TASK)
+				tail[level] = prev[taskId];
+			else
+				prev[next[taskId]] = prev[taskId];
+
+			next[taskId] = prev[taskId] = NO_TASK;
+
+			if (head[level] == NO_TASK)
+			{
+				bitmap[level / 64] &= ~(1ULL << (level % 64));
+				if (bitmap[level / 64] == 0)
+					summary &= ~(1ULL << (level / 64));
+			}
+		}
+
+		int size;
+		int *priority;
+		TaskState *state;
+		int *next;
+		int *prev;
+
+		int head[PRIORITY_LEVELS];
+		int tail[PRIORITY_LEVELS];
+		uint64_t bitmap[PRIORITY_WORDS];
+		uint64_t summary;
+};
+
+#endif
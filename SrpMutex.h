@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <vector>
+
+#include "CeilingStack.h"
+#include "Log.h"
+#include "Profile.h"
+#include "ReadyQueue.h"
+#include "Trace.h"
+
+#ifndef SrpMutex_h
+#define SrpMutex_h
+
+//-----------------------------------------------------------------------------------------
+// SrpMutex (Stack Resource Policy Mutex) class definition and implementation.
+// Works as a wrapper around standard pthread_mutex functions (emulated protocol only).
+// Every task has a static preemption level (its base priority), every resource a ceiling
+// (highest preemption level of its users, see TaskSet::computeCeilings). A released job
+// is admitted only if its preemption level is above the system ceiling (highest ceiling
+// of the locked mutexes), otherwise it is suspended until an unlock lowers the ceiling.
+// An admitted job finds every resource it needs free: lock never blocks and priorities
+// are never changed, so all jobs could share one stack.
+//-----------------------------------------------------------------------------------------
+class SrpMutex
+{
+	//-----------------------------------------------------------------------------------------
+	// Deferred job data holder
+	//-----------------------------------------------------------------------------------------
+	struct ThreadInfo
+	{
+		int threadId;
+		int preemptionLevel;
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Constructor (initializes srpMutex)
+		//-----------------------------------------------------------------------------------------
+		SrpMutex()
+		{
+			Log<LOG_INFO>::print("Initializing srpMutex ...\n");
+			pthread_mutex_init(&srpMutex, NULL);
+
+			// set with setCsPriority, computed in advance by TaskSet::computeCeilings
+			csPriority = 0;
+			mutexId = 0;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Destructor
+		//-----------------------------------------------------------------------------------------
+		~SrpMutex()
+		{
+			Log<LOG_INFO>::print("Destroying srpMutex ...\n");
+			int status = pthread_mutex_destroy(&srpMutex);
+			if (status != 0)
+				Log<LOG_ERROR>::print("Error destroying srpMutex");
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Admission test of a released job (preemption level = base priority). Returns true if
+		// the job may start, otherwise suspends it until the system ceiling drops below its
+		// preemption level. O(1).
+		//-----------------------------------------------------------------------------------------
+		static bool admit(int threadId, int preemptionLevel, ReadyQueue* queue)
+		{
+			int ceiling = getSystemCeiling();
+			if (preemptionLevel > ceiling)
+				return true;
+
+			Trace::record(TRACE_SRP_DEFER, threadId, getCeilingMutex()->getId(), preemptionLevel, ceiling);
+			ThreadInfo threadData;
+			threadData.threadId = threadId;
+			threadData.preemptionLevel = preemptionLevel;
+			deferred.push_back(threadData);
+			queue->suspend(threadId);
+			return false;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Locks srpMutex and raises the system ceiling. Admission guarantees that the mutex is
+		// free, a busy mutex means the ceiling is too low (the lock is retried on next dispatch).
+		// Returns 0 (success) or error code (failure).
+		//-----------------------------------------------------------------------------------------
+		int lock(int threadId)
+		{
+			int lockStatus = pthread_mutex_trylock(&srpMutex);
+			if (lockStatus != 0)
+			{
+				Profile::contended(getId(), threadId);
+				Trace::record(TRACE_SRP_LOCK_ERROR, threadId, getId(), 0, 0);
+				return lockStatus;
+			}
+
+			hold.acquired(getId(), threadId);
+			ceilingStack.push(this);
+			Trace::record(TRACE_SRP_LOCKING, threadId, getId(), getSystemCeiling(), 0);
+			return lockStatus;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Unlocks srpMutex, lowers the system ceiling and resumes the deferred jobs whose
+		// preemption level is now above it. O(deferred jobs).
+		//-----------------------------------------------------------------------------------------
+		int unlock(int threadId, ReadyQueue* queue)
+		{
+			hold.released(getId());
+
+			int unlockStatus = pthread_mutex_unlock(&srpMutex);
+			if (unlockStatus != 0)
+				return unlockStatus;
+
+			ceilingStack.pop(this);
+			int ceiling = getSystemCeiling();
+			Trace::record(TRACE_SRP_UNLOCKED, threadId, getId(), ceiling, 0);
+
+			size_t kept = 0;
+			for (size_t i = 0; i < deferred.size(); i++)
+			{
+				if (deferred[i].preemptionLevel > ceiling)
+				{
+					Trace::record(TRACE_SRP_ADMIT, deferred[i].threadId, getId(), deferred[i].preemptionLevel, ceiling);
+					queue->resume(deferred[i].threadId);
+				}
+				else
+					deferred[kept++] = deferred[i];
+			}
+			deferred.resize(kept);
+
+			return unlockStatus;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Sets critical section priority (resource ceiling).
+		//-----------------------------------------------------------------------------------------
+		void setCsPriority(int priority)
+		{
+			csPriority = priority;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns critical section priority (resource ceiling).
+		//-----------------------------------------------------------------------------------------
+		int getCsPriority()
+		{
+			return csPriority;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the system ceiling, 0 if no mutex is locked.
+		//-----------------------------------------------------------------------------------------
+		static int getSystemCeiling()
+		{
+			return ceilingStack.getCeiling();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the mutex holding the system ceiling, NULL if no mutex is locked.
+		//-----------------------------------------------------------------------------------------
+		static SrpMutex* getCeilingMutex()
+		{
+			return ceilingStack.getCeilingMutex();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Sets mutex id.
+		//-----------------------------------------------------------------------------------------
+		void setId(int id)
+		{
+			mutexId = id;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns mutex id.
+		//-----------------------------------------------------------------------------------------
+		int getId()
+		{
+			return mutexId;
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		// locked mutexes in locking order, shared by all SrpMutex instances
+		static inline CeilingStack<SrpMutex> ceilingStack;
+
+		// released jobs waiting for admission, shared by all SrpMutex instances
+		static inline std::vector<ThreadInfo> deferred;
+
+		pthread_mutex_t srpMutex;
+		int csPriority;
+		int mutexId;
+		ProfileHold hold;
+};
+
+#endif
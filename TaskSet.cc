@@ -0,0 +1,388 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "Log.h"
+#include "ReadyQueue.h"
+#include "TaskSet.h"
+
+//---------------------------------------------------------------------------------------------
+// TaskSet class implementation (streaming task set file parser).
+//---------------------------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------------------
+	// Converts token to a non-negative integer, returns false if it is not one.
+	//-----------------------------------------------------------------------------------------
+	static bool parseNumber(const char* token, int* value)
+	{
+		if (token == NULL || *token < '0' || *token > '9')
+			return false;
+
+		char *end;
+		errno = 0;
+		long number = strtol(token, &end, 10);
+		if (*end != '\0' || errno != 0 || number > 0x7fffffffL)
+			return false;
+
+		*value = (int) number;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Constructor
+	//-----------------------------------------------------------------------------------------
+	TaskSet::TaskSet()
+	{
+		path = "";
+		endTime = DEFAULT_END_TIME;
+		timeUnit = DEFAULT_TIME_UNIT;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Loads task set file. Reads one line at a time, so memory use is bounded by the
+	// task set itself (not the file size).
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::load(const char* path)
+	{
+		this->path = path;
+
+		FILE *file = fopen(path, "r");
+		if (file == NULL)
+		{
+			Log<LOG_ERROR>::print("Error opening task set %s\n", path);
+			return -1;
+		}
+
+		char *line = NULL;
+		size_t capacity = 0;
+		int lineNumber = 0;
+		int status = 0;
+		while (status == 0 && getline(&line, &capacity, file) != -1)
+			status = parseLine(line, path, ++lineNumber);
+
+		free(line);
+		fclose(file);
+
+		if (status == 0 && tasks.empty())
+		{
+			Log<LOG_ERROR>::print("%s: no tasks declared\n", path);
+			status = -1;
+		}
+
+		return status;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Parses one line (directive and its arguments).
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::parseLine(char* line, const char* path, int lineNumber)
+	{
+		char *comment = strchr(line, '#');
+		if (comment != NULL)
+			*comment = '\0';
+
+		char *save;
+		char *directive = strtok_r(line, " \t\r\n", &save);
+		if (directive == NULL)
+			return 0;
+
+		if (strcmp(directive, "task") == 0)
+			return parseTask(save, path, lineNumber);
+
+		if (strcmp(directive, "resource") == 0)
+		{
+			int id, ceiling = 0;
+			bool immediate = false;
+			bool valid = parseNumber(strtok_r(NULL, " \t\r\n", &save), &id) && id != 0 && id <= MAX_RESOURCE_ID;
+			char *keyword;
+			while (valid && (keyword = strtok_r(NULL, " \t\r\n", &save)) != NULL)
+			{
+				if (strcmp(keyword, "ceiling") == 0)
+					valid = parseNumber(strtok_r(NULL, " \t\r\n", &save), &ceiling) && ceiling < PRIORITY_LEVELS;
+				else if (strcmp(keyword, "immediate") == 0)
+					immediate = true;
+				else
+					valid = false;
+			}
+
+			if (!valid)
+			{
+				Log<LOG_ERROR>::print("%s:%d: expected 'resource <id> [ceiling <priority>] [immediate]'\n",
+						path, lineNumber);
+				return -1;
+			}
+
+			ResourceSpec *resource = declareResource(id);
+			resource->declaredCeiling = ceiling;
+			resource->declaredLine = lineNumber;
+			resource->immediate = immediate;
+			return 0;
+		}
+
+		if (strcmp(directive, "end") == 0)
+		{
+			if (!parseNumber(strtok_r(NULL, " \t\r\n", &save), &endTime))
+			{
+				Log<LOG_ERROR>::print("%s:%d: expected 'end <time>'\n", path, lineNumber);
+				return -1;
+			}
+			return 0;
+		}
+
+		if (strcmp(directive, "unit") == 0)
+		{
+			if (!parseNumber(strtok_r(NULL, " \t\r\n", &save), &timeUnit) || timeUnit == 0)
+			{
+				Log<LOG_ERROR>::print("%s:%d: expected 'unit <microseconds>'\n", path, lineNumber);
+				return -1;
+			}
+			return 0;
+		}
+
+		Log<LOG_ERROR>::print("%s:%d: unknown directive '%s'\n", path, lineNumber, directive);
+		return -1;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Parses "<id> <release> <period> <priority> <segment> ..." and appends the task.
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::parseTask(char* args, const char* path, int lineNumber)
+	{
+		TaskSpec task;
+		char *save;
+		if (!parseNumber(strtok_r(args, " \t\r\n", &save), &task.id) || task.id == 0 || task.id > MAX_TASK_ID
+				|| !parseNumber(strtok_r(NULL, " \t\r\n", &save), &task.release)
+				|| !parseNumber(strtok_r(NULL, " \t\r\n", &save), &task.period)
+				|| !parseNumber(strtok_r(NULL, " \t\r\n", &save), &task.priority)
+				|| task.priority == 0 || task.priority >= PRIORITY_LEVELS)
+		{
+			Log<LOG_ERROR>::print("%s:%d: expected 'task <id> <release> <period> <priority> <segment> ...'\n",
+					path, lineNumber);
+			return -1;
+		}
+
+		if ((int) taskIds.size() <= task.id)
+			taskIds.resize(task.id + 1, false);
+		if (taskIds[task.id])
+		{
+			Log<LOG_ERROR>::print("%s:%d: task %d declared twice\n", path, lineNumber, task.id);
+			return -1;
+		}
+		taskIds[task.id] = true;
+
+		std::vector<int> held;		// resources locked by the script so far
+		task.firstSegment = segments.size();
+		for (char *token = strtok_r(NULL, " \t\r\n", &save); token != NULL; token = strtok_r(NULL, " \t\r\n", &save))
+		{
+			TaskSegment segment;
+			switch (token[0])
+			{
+				case 'C': segment.type = SEGMENT_COMPUTE; break;
+				case 'L': segment.type = SEGMENT_LOCK; break;
+				case 'U': segment.type = SEGMENT_UNLOCK; break;
+				default: segment.type = -1; break;
+			}
+
+			if (segment.type == -1 || !parseNumber(token + 1, &segment.value) || segment.value == 0
+					|| (segment.type != SEGMENT_COMPUTE && segment.value > MAX_RESOURCE_ID))
+			{
+				Log<LOG_ERROR>::print("%s:%d: invalid segment '%s' (expected C<n>, L<r> or U<r>)\n",
+						path, lineNumber, token);
+				return -1;
+			}
+
+			if (checkLocking(&segment, &held, path, lineNumber) != 0)
+				return -1;
+
+			if (segment.type != SEGMENT_COMPUTE)
+				declareResource(segment.value);
+
+			segments.push_back(segment);
+		}
+		task.segmentCount = segments.size() - task.firstSegment;
+
+		if (!held.empty())
+		{
+			Log<LOG_ERROR>::print("%s:%d: task %d ends with resource %d locked\n",
+					path, lineNumber, task.id, held.back());
+			return -1;
+		}
+
+		tasks.push_back(task);
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Checks that a lock segment locks a resource not held yet and an unlock segment one
+	// that is held (critical sections may overlap, unlock order is free). held is the list
+	// of resources locked so far by the script. O(held).
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::checkLocking(TaskSegment* segment, std::vector<int>* held, const char* path, int lineNumber)
+	{
+		if (segment->type == SEGMENT_LOCK)
+		{
+			for (size_t i = 0; i < held->size(); i++)
+			{
+				if ((*held)[i] == segment->value)
+				{
+					Log<LOG_ERROR>::print("%s:%d: resource %d locked again while held\n",
+							path, lineNumber, segment->value);
+					return -1;
+				}
+			}
+
+			held->push_back(segment->value);
+		}
+		else if (segment->type == SEGMENT_UNLOCK)
+		{
+			for (size_t i = 0; i < held->size(); i++)
+			{
+				if ((*held)[i] == segment->value)
+				{
+					held->erase(held->begin() + i);
+					return 0;
+				}
+			}
+
+			Log<LOG_ERROR>::print("%s:%d: resource %d unlocked but not locked\n",
+					path, lineNumber, segment->value);
+			return -1;
+		}
+
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Declares resource (and all lower ids), returns its spec.
+	//-----------------------------------------------------------------------------------------
+	ResourceSpec* TaskSet::declareResource(int id)
+	{
+		while ((int) resources.size() < id)
+		{
+			ResourceSpec resource;
+			resource.id = resources.size() + 1;
+			resource.ceiling = 0;
+			resource.declaredCeiling = 0;
+			resource.declaredLine = 0;
+			resource.immediate = false;
+			resources.push_back(resource);
+		}
+
+		return &resources[id - 1];
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Computes every resource ceiling as the highest priority of the tasks locking it
+	// (one pass over all scripts, O(tasks + segments + resources)). A declared ceiling
+	// above the computed one is kept (conservative), one below it is replaced, as it would
+	// let a task lock the resource while a higher priority user could still need it.
+	// Returns number of resources whose declared ceiling differs from the computed one.
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::computeCeilings()
+	{
+		for (size_t i = 0; i < resources.size(); i++)
+			resources[i].ceiling = 0;
+
+		for (size_t i = 0; i < tasks.size(); i++)
+		{
+			int last = tasks[i].firstSegment + tasks[i].segmentCount;
+			for (int j = tasks[i].firstSegment; j < last; j++)
+			{
+				// compute segment values are tick counts, not resource ids
+				if (segments[j].type != SEGMENT_LOCK)
+					continue;
+
+				ResourceSpec *resource = &resources[segments[j].value - 1];
+				if (resource->ceiling < tasks[i].priority)
+					resource->ceiling = tasks[i].priority;
+			}
+		}
+
+		int mismatches = 0;
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			ResourceSpec *resource = &resources[i];
+			if (resource->declaredCeiling == 0 || resource->declaredCeiling == resource->ceiling)
+				continue;
+
+			mismatches++;
+			if (resource->declaredCeiling < resource->ceiling)
+				Log<LOG_ERROR>::print("%s:%d: resource %d ceiling %d is below computed ceiling %d, using %d\n",
+						path, resource->declaredLine, resource->id, resource->declaredCeiling,
+						resource->ceiling, resource->ceiling);
+			else
+			{
+				Log<LOG_INFO>::print("%s:%d: resource %d ceiling %d is above computed ceiling %d\n",
+						path, resource->declaredLine, resource->id, resource->declaredCeiling,
+						resource->ceiling);
+				resource->ceiling = resource->declaredCeiling;
+			}
+		}
+
+		return mismatches;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns number of tasks.
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::getTaskCount()
+	{
+		return tasks.size();
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns task by index.
+	//-----------------------------------------------------------------------------------------
+	TaskSpec* TaskSet::getTask(int index)
+	{
+		return &tasks[index];
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns script segment by index.
+	//-----------------------------------------------------------------------------------------
+	TaskSegment* TaskSet::getSegment(int index)
+	{
+		return &segments[index];
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns number of resources (highest resource id).
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::getResourceCount()
+	{
+		return resources.size();
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns resource by id (1 .. getResourceCount()).
+	//-----------------------------------------------------------------------------------------
+	ResourceSpec* TaskSet::getResource(int id)
+	{
+		return &resources[id - 1];
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns highest task id.
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::getMaxTaskId()
+	{
+		return taskIds.size() - 1;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns simulation length.
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::getEndTime()
+	{
+		return endTime;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns length of one tick (microseconds).
+	//-----------------------------------------------------------------------------------------
+	int TaskSet::getTimeUnit()
+	{
+		return timeUnit;
+	}
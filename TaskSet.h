@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <vector>
+
+#ifndef TaskSet_h
+#define TaskSet_h
+
+#define DEFAULT_END_TIME 30		// simulation length if the task set does not specify one
+#define DEFAULT_TIME_UNIT 1000000	// microseconds per tick if the task set does not specify it
+#define MAX_TASK_ID 1000000			// per-thread tables of the scheduler are sized by the highest id
+#define MAX_RESOURCE_ID 65535		// trace events and mutex statistics keep 16-bit mutex ids
+
+//-----------------------------------------------------------------------------------------
+// Script segment types
+//-----------------------------------------------------------------------------------------
+enum SegmentType
+{
+	SEGMENT_COMPUTE,	// execute for value ticks
+	SEGMENT_LOCK,		// lock resource value
+	SEGMENT_UNLOCK		// unlock resource value
+};
+
+//-----------------------------------------------------------------------------------------
+// Script segment (compute/lock/unlock step of a task)
+//-----------------------------------------------------------------------------------------
+struct TaskSegment
+{
+	int type;
+	int value;
+};
+
+//-----------------------------------------------------------------------------------------
+// Task declaration. Its script is segments [firstSegment, firstSegment + segmentCount).
+//-----------------------------------------------------------------------------------------
+struct TaskSpec
+{
+	int id;				// 1 .. n, also the scheduler's thread id
+	int release;		// first release time (ticks)
+	int period;			// 0 = one-shot
+	int priority;		// 1 .. PRIORITY_LEVELS-1
+	int firstSegment;
+	int segmentCount;
+};
+
+//-----------------------------------------------------------------------------------------
+// Resource declaration (ceiling 0 = not specified)
+//-----------------------------------------------------------------------------------------
+struct ResourceSpec
+{
+	int id;
+	int ceiling;			// ceiling used for the run
+	int declaredCeiling;	// 'resource <id> ceiling <p>' value, 0 = not declared
+	int declaredLine;		// line of the ceiling declaration
+	bool immediate;			// 'immediate': immediate ceiling protocol (PcMutex)
+};
+
+//-----------------------------------------------------------------------------------------
+// TaskSet class definition.
+// Loads a task set file line by line. Format ('#' starts a comment):
+//
+//   end <time>                                 simulation length (default 30)
+//   unit <microseconds>                        length of one tick in real time (default 1 s)
+//   resource <id> [ceiling <priority>] [immediate]
+//                                              optional (ceilings are computed, see computeCeilings),
+//                                              immediate: owner runs at the ceiling (-p pc)
+//   task <id> <release> <period> <priority> <segment> ...
+//
+// Segments: C<n> compute for n ticks, L<r> lock resource r, U<r> unlock resource r.
+// Every dispatch executes lock/unlock segments up to and including one compute tick.
+// A resource is locked at most once at a time and unlocked only while held (in any order),
+// and every lock is unlocked before the script ends.
+//-----------------------------------------------------------------------------------------
+class TaskSet
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		// constructor
+		TaskSet();
+
+		// loads task set file, returns 0 (success) or -1 (failure)
+		int load(const char* path);
+
+		// returns number of tasks
+		int getTaskCount();
+
+		// returns task by index (0 .. getTaskCount()-1)
+		TaskSpec* getTask(int index);
+
+		// returns script segment by index
+		TaskSegment* getSegment(int index);
+
+		// returns highest resource id (resources are numbered 1 .. getResourceCount())
+		int getResourceCount();
+
+		// returns resource by id
+		ResourceSpec* getResource(int id);
+
+		// computes resource ceilings from the task scripts, returns number of mismatches
+		int computeCeilings();
+
+		// returns highest task id
+		int getMaxTaskId();
+
+		// returns simulation length
+		int getEndTime();
+
+		// returns length of one tick (microseconds)
+		int getTimeUnit();
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		std::vector<TaskSpec> tasks;
+		std::vector<TaskSegment> segments;
+		std::vector<ResourceSpec> resources;
+		std::vector<bool> taskIds;
+		const char* path;
+		int endTime;
+		int timeUnit;
+
+	//-----------------------------------------------------------------------------------------
+	// Protected members
+	//-----------------------------------------------------------------------------------------
+	protected:
+
+		// parses one line, returns 0 (success) or -1 (syntax error)
+		int parseLine(char* line, const char* path, int lineNumber);
+
+		// parses task declaration
+		int parseTask(char* args, const char* path, int lineNumber);
+
+		// checks a lock/unlock segment against the held resources, returns 0 or -1
+		int checkLocking(TaskSegment* segment, std::vector<int>* held, const char* path, int lineNumber);
+
+		// declares resource (if not already declared), returns its spec
+		ResourceSpec* declareResource(int id);
+};
+
+#endif
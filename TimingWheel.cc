@@ -0,0 +1,213 @@
+#include <string.h>
+
+#include "TimingWheel.h"
+
+//---------------------------------------------------------------------------------------------
+// TimingWheel class implementation.
+//---------------------------------------------------------------------------------------------
+
+// index of the due events list
+#define WHEEL_DUE (WHEEL_LEVELS * WHEEL_SLOTS)
+
+	//-----------------------------------------------------------------------------------------
+	// Constructor
+	//-----------------------------------------------------------------------------------------
+	TimingWheel::TimingWheel(uint64_t time)
+	{
+		memset(slots, 0, sizeof(slots));
+		memset(occupied, 0, sizeof(occupied));
+		levels = 0;
+		this->time = time;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Initializes event (not scheduled).
+	//-----------------------------------------------------------------------------------------
+	void TimingWheel::init(TimerEvent* event, int type, int data)
+	{
+		event->expiry = 0;
+		event->type = type;
+		event->data = data;
+		event->next = event->prev = NULL;
+		event->slot = -1;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Schedules event at expiry (O(1)).
+	//-----------------------------------------------------------------------------------------
+	void TimingWheel::schedule(TimerEvent* event, uint64_t expiry)
+	{
+		cancel(event);
+		event->expiry = expiry;
+		insert(event);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Removes pending event (O(1)).
+	//-----------------------------------------------------------------------------------------
+	void TimingWheel::cancel(TimerEvent* event)
+	{
+		if (event->slot >= 0)
+			unlink(event);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Advances wheel time up to time and returns the next due event (in expiry order).
+	// The lowest occupied slot is emptied: due events move to the due list, the others are
+	// filed again relative to the new wheel time (a lower level). Stops at time, or when
+	// an event is due.
+	//-----------------------------------------------------------------------------------------
+	TimerEvent* TimingWheel::expire(uint64_t time)
+	{
+		while (slots[WHEEL_DUE].head == NULL && levels != 0)
+		{
+			int level = __builtin_ctz(levels);
+			int slot = __builtin_ctzll(occupied[level]);
+			uint64_t start = slotStart(level, slot);
+			if (start > time)
+				break;
+
+			this->time = start;
+
+			Slot &current = slots[level * WHEEL_SLOTS + slot];
+			TimerEvent *event = current.head;
+			current.head = current.tail = NULL;
+			occupied[level] &= ~(1ULL << slot);
+			if (occupied[level] == 0)
+				levels &= ~(1U << level);
+
+			while (event != NULL)
+			{
+				TimerEvent *next = event->next;
+				insert(event);
+				event = next;
+			}
+		}
+
+		TimerEvent *event = slots[WHEEL_DUE].head;
+		if (event != NULL)
+		{
+			unlink(event);
+			return event;
+		}
+
+		if (time > this->time)
+			this->time = time;
+		return NULL;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns expiry of the earliest pending event. Exact on level 0, higher levels are
+	// searched within their lowest occupied slot.
+	//-----------------------------------------------------------------------------------------
+	uint64_t TimingWheel::nextExpiry()
+	{
+		if (slots[WHEEL_DUE].head != NULL)
+			return time;
+		if (levels == 0)
+			return WHEEL_NEVER;
+
+		int level = __builtin_ctz(levels);
+		int slot = __builtin_ctzll(occupied[level]);
+		if (level == 0)
+			return slotStart(0, slot);
+
+		uint64_t next = WHEEL_NEVER;
+		for (TimerEvent *event = slots[level * WHEEL_SLOTS + slot].head; event != NULL; event = event->next)
+		{
+			if (event->expiry < next)
+				next = event->expiry;
+		}
+
+		return next;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns wheel time.
+	//-----------------------------------------------------------------------------------------
+	uint64_t TimingWheel::getTime()
+	{
+		return time;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns true if event is pending.
+	//-----------------------------------------------------------------------------------------
+	bool TimingWheel::isScheduled(TimerEvent* event)
+	{
+		return event->slot >= 0;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Files event at the level of the highest bit that differs from the wheel time.
+	//-----------------------------------------------------------------------------------------
+	void TimingWheel::insert(TimerEvent* event)
+	{
+		if (event->expiry <= time)
+		{
+			append(WHEEL_DUE, event);
+			return;
+		}
+
+		int level = (63 - __builtin_clzll(event->expiry ^ time)) / WHEEL_BITS;
+		int slot = (int) (event->expiry >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+		append(level * WHEEL_SLOTS + slot, event);
+
+		occupied[level] |= 1ULL << slot;
+		levels |= 1U << level;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Appends event to slot.
+	//-----------------------------------------------------------------------------------------
+	void TimingWheel::append(int slot, TimerEvent* event)
+	{
+		Slot &list = slots[slot];
+		event->slot = slot;
+		event->next = NULL;
+		event->prev = list.tail;
+		if (list.tail != NULL)
+			list.tail->next = event;
+		else
+			list.head = event;
+		list.tail = event;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Unlinks event from its slot, clears the occupancy bits of an emptied slot.
+	//-----------------------------------------------------------------------------------------
+	void TimingWheel::unlink(TimerEvent* event)
+	{
+		Slot &list = slots[event->slot];
+		if (event->prev != NULL)
+			event->prev->next = event->next;
+		else
+			list.head = event->next;
+		if (event->next != NULL)
+			event->next->prev = event->prev;
+		else
+			list.tail = event->prev;
+
+		if (list.head == NULL && event->slot != WHEEL_DUE)
+		{
+			int level = event->slot / WHEEL_SLOTS;
+			occupied[level] &= ~(1ULL << (event->slot % WHEEL_SLOTS));
+			if (occupied[level] == 0)
+				levels &= ~(1U << level);
+		}
+
+		event->next = event->prev = NULL;
+		event->slot = -1;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns start time of slot at level: the wheel time above the level, the slot index
+	// at the level, zeros below.
+	//-----------------------------------------------------------------------------------------
+	uint64_t TimingWheel::slotStart(int level, int slot)
+	{
+		int shift = level * WHEEL_BITS;
+		int above = shift + WHEEL_BITS;
+		uint64_t high = (above >= 64) ? 0 : (time >> above) << above;
+		return high | ((uint64_t) slot << shift);
+	}
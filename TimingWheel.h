@@ -0,0 +1,100 @@
+#include <stdint.h>
+
+#ifndef TimingWheel_h
+#define TimingWheel_h
+
+#define WHEEL_BITS 6											// slots per level = 2^WHEEL_BITS
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS ((64 + WHEEL_BITS - 1) / WHEEL_BITS)		// levels cover all 64-bit times
+#define WHEEL_NEVER UINT64_MAX									// no pending event
+
+//-----------------------------------------------------------------------------------------
+// Timer event, owned by the caller (the wheel only links it). Type and data are not
+// interpreted by the wheel.
+//-----------------------------------------------------------------------------------------
+struct TimerEvent
+{
+	uint64_t expiry;		// absolute time (wheel units)
+	int type;
+	int data;
+
+	TimerEvent *next;		// slot list links
+	TimerEvent *prev;
+	int slot;				// slot index, -1 = not scheduled
+};
+
+//-----------------------------------------------------------------------------------------
+// TimingWheel class definition.
+// Hierarchical timing wheel: level L has WHEEL_SLOTS slots of 2^(L*WHEEL_BITS) time units.
+// An event is filed at the level of the highest bit in which its expiry differs from the
+// wheel time, so a level never wraps around and the lowest occupied slot of the lowest
+// occupied level (occupancy bitmaps, count-trailing-zeros) holds the earliest events.
+// Scheduling and cancelling are O(1), expiring moves an event down at most WHEEL_LEVELS
+// times, jumps over empty time cost nothing. Resolution is left to the caller: with
+// microseconds, 2^48 units still span 8 years. Not thread safe (CPU mutex).
+//-----------------------------------------------------------------------------------------
+class TimingWheel
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		// constructor (wheel time starts at time)
+		TimingWheel(uint64_t time = 0);
+
+		// initializes event (not scheduled)
+		static void init(TimerEvent* event, int type, int data);
+
+		// schedules event at expiry (already due if expiry <= wheel time), reschedules if pending
+		void schedule(TimerEvent* event, uint64_t expiry);
+
+		// removes pending event (no effect if not scheduled)
+		void cancel(TimerEvent* event);
+
+		// advances wheel time up to time, returns next due event (NULL if none is due)
+		TimerEvent* expire(uint64_t time);
+
+		// returns expiry of the earliest pending event, WHEEL_NEVER if none
+		uint64_t nextExpiry();
+
+		// returns wheel time
+		uint64_t getTime();
+
+		// returns true if event is pending
+		static bool isScheduled(TimerEvent* event);
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		// event list (FIFO, keeps the scheduling order of equal expiries)
+		struct Slot
+		{
+			TimerEvent *head;
+			TimerEvent *tail;
+		};
+
+		Slot slots[WHEEL_LEVELS * WHEEL_SLOTS + 1];		// last slot: due events
+		uint64_t occupied[WHEEL_LEVELS];				// non-empty slots per level
+		uint32_t levels;								// non-empty levels
+		uint64_t time;
+
+	//-----------------------------------------------------------------------------------------
+	// Protected members
+	//-----------------------------------------------------------------------------------------
+	protected:
+
+		// files event relative to the wheel time
+		void insert(TimerEvent* event);
+
+		// appends event to slot
+		void append(int slot, TimerEvent* event);
+
+		// unlinks event from its slot
+		void unlink(TimerEvent* event);
+
+		// returns start time of slot at level (relative to the wheel time)
+		uint64_t slotStart(int level, int slot);
+};
+
+#endif
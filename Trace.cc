@@ -0,0 +1,355 @@
+
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <queue>
+#include <vector>
+
+#include "Log.h"
+#include "Trace.h"
+
+//---------------------------------------------------------------------------------------------
+// Trace implementation: per-thread ring buffers, drainer thread and timeline formatting.
+//---------------------------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------------------
+	// Orders pending events by sequence number (smallest first).
+	//-----------------------------------------------------------------------------------------
+	struct LaterSequence
+	{
+		bool operator()(const TraceEvent& a, const TraceEvent& b) const
+		{
+			return a.sequence > b.sequence;
+		}
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Releases the thread's buffer for reuse when the owning thread exits.
+	//-----------------------------------------------------------------------------------------
+	struct TraceBufferOwner
+	{
+		TraceBuffer *buffer;
+
+		~TraceBufferOwner()
+		{
+			if (buffer != NULL)
+				buffer->retired.store(true, std::memory_order_release);
+		}
+	};
+
+	static std::atomic<TraceBuffer*> registry(NULL);	// all buffers, append only
+	static std::atomic<uint64_t> sequence(0);			// global event order
+	static std::atomic<bool> draining(false);			// drainer running
+	static thread_local TraceBufferOwner owner = {NULL};
+
+	static pthread_t drainer;
+	static FILE *output = NULL;
+	static bool binary = false;
+	static uint64_t nextSequence = 0;
+	static std::priority_queue<TraceEvent, std::vector<TraceEvent>, LaterSequence> pending;
+
+	//-----------------------------------------------------------------------------------------
+	// Returns the calling thread's buffer, reuses a buffer of an exited thread if possible.
+	// Runs once per thread, never on the recording path afterwards.
+	//-----------------------------------------------------------------------------------------
+	static TraceBuffer* attachBuffer()
+	{
+		for (TraceBuffer *b = registry.load(std::memory_order_acquire); b != NULL; b = b->next)
+		{
+			bool retired = true;
+			if (b->head.load(std::memory_order_relaxed) == b->tail.load(std::memory_order_acquire)
+					&& b->retired.compare_exchange_strong(retired, false))
+				return b;
+		}
+
+		TraceBuffer *buffer = new TraceBuffer;
+		buffer->head.store(0, std::memory_order_relaxed);
+		buffer->tail.store(0, std::memory_order_relaxed);
+		buffer->retired.store(false, std::memory_order_relaxed);
+
+		buffer->next = registry.load(std::memory_order_relaxed);
+		while (!registry.compare_exchange_weak(buffer->next, buffer, std::memory_order_release))
+			;
+
+		return buffer;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Records one event. Never takes a lock, only waits (yields) if the drainer fell behind
+	// by a whole buffer, so no event is lost. Does nothing while tracing is stopped.
+	//-----------------------------------------------------------------------------------------
+	void Trace::record(int type, int taskId, int mutexId, int priority, int arg)
+	{
+		if (!draining.load(std::memory_order_relaxed))
+			return;
+
+		if (owner.buffer == NULL)
+			owner.buffer = attachBuffer();
+		TraceBuffer *buffer = owner.buffer;
+
+		uint32_t head = buffer->head.load(std::memory_order_relaxed);
+		while (head - buffer->tail.load(std::memory_order_acquire) >= TRACE_BUFFER_SIZE)
+			sched_yield();
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		TraceEvent &event = buffer->events[head & (TRACE_BUFFER_SIZE - 1)];
+		event.sequence = sequence.fetch_add(1, std::memory_order_relaxed);
+		event.timestamp = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+		event.type = type;
+		event.mutexId = mutexId;
+		event.taskId = taskId;
+		event.priority = priority;
+		event.arg = arg;
+
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Writes event to the output (binary record or timeline text).
+	//-----------------------------------------------------------------------------------------
+	static void emit(const TraceEvent& event)
+	{
+		if (binary)
+			fwrite(&event, sizeof(event), 1, output);
+		else
+		{
+			char text[256];
+			Trace::format(event, text, sizeof(text));
+			fputs(text, output);
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Moves all published events to the pending queue, emits the ones that are next in
+	// sequence. Flushes everything if final. Returns number of events collected.
+	//-----------------------------------------------------------------------------------------
+	static int drainOnce(bool final)
+	{
+		int collected = 0;
+		for (TraceBuffer *b = registry.load(std::memory_order_acquire); b != NULL; b = b->next)
+		{
+			uint32_t head = b->head.load(std::memory_order_acquire);
+			uint32_t tail = b->tail.load(std::memory_order_relaxed);
+			for (; tail != head; tail++, collected++)
+				pending.push(b->events[tail & (TRACE_BUFFER_SIZE - 1)]);
+			b->tail.store(tail, std::memory_order_release);
+		}
+
+		while (!pending.empty() && (final || pending.top().sequence == nextSequence))
+		{
+			emit(pending.top());
+			nextSequence = pending.top().sequence + 1;
+			pending.pop();
+		}
+
+		return collected;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Drainer thread: polls buffers while running, sleeps briefly when idle.
+	//-----------------------------------------------------------------------------------------
+	static void* drain(void*)
+	{
+		while (draining.load(std::memory_order_acquire))
+		{
+			if (drainOnce(false) == 0)
+				usleep(100);
+		}
+
+		drainOnce(true);
+		fflush(output);
+
+		return NULL;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Starts the drainer. Returns 0 (success) or -1 (failure).
+	//-----------------------------------------------------------------------------------------
+	int Trace::start(const char* path)
+	{
+		if (draining.load())
+			return -1;
+
+		binary = (path != NULL);
+		if (binary)
+		{
+			output = fopen(path, "wb");
+			if (output == NULL)
+			{
+				Log<LOG_ERROR>::print("Error opening trace file %s\n", path);
+				return -1;
+			}
+
+			TraceFileHeader header;
+			memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+			header.version = TRACE_VERSION;
+			header.eventSize = sizeof(TraceEvent);
+			fwrite(&header, sizeof(header), 1, output);
+		}
+		else
+		{
+			fflush(stdout);
+			output = stdout;
+		}
+
+		draining.store(true, std::memory_order_release);
+		if (pthread_create(&drainer, NULL, drain, NULL) != 0)
+		{
+			Log<LOG_ERROR>::print("Error creating trace drainer\n");
+			draining.store(false);
+			return -1;
+		}
+
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Stops the drainer after all recorded events have been written.
+	//-----------------------------------------------------------------------------------------
+	void Trace::stop()
+	{
+		if (!draining.load())
+			return;
+
+		draining.store(false, std::memory_order_release);
+		pthread_join(drainer, NULL);
+
+		if (binary)
+			fclose(output);
+		output = NULL;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Formats event as it appears in the simulation timeline (doc/logs_*.txt). Priorities
+	// 0..255 print as hundredths (70 as 0.70), like the priorities of the original logs.
+	//-----------------------------------------------------------------------------------------
+	int Trace::format(const TraceEvent& e, char* text, size_t size)
+	{
+		switch (e.type)
+		{
+			case TRACE_SCHEDULER_LOCK:
+				return snprintf(text, size, "\nScheduler: lock CPU mutex");
+			case TRACE_SCHEDULER_UNLOCK:
+				return snprintf(text, size, "\nScheduler: unlock CPU mutex");
+			case TRACE_RELEASE:
+				return snprintf(text, size, "\nP%d released", e.taskId);
+			case TRACE_ACTIVATE:
+				return snprintf(text, size, "\nThread manager: activate thread %d", e.taskId);
+			case TRACE_NOTIFY:
+				return snprintf(text, size, "\nThread manager: notify thread %d", e.taskId);
+			case TRACE_TICK:
+				return snprintf(text, size, "\n\n timer tick: %d\n", e.arg);
+			case TRACE_TICKS_MISSED:
+				return snprintf(text, size, "\nScheduler: %d timer tick(s) missed", e.arg);
+			case TRACE_TERMINATE:
+				return snprintf(text, size, "\n\n%d ticks are over, terminate program", e.arg);
+
+			case TRACE_TASK_LOCK_CPU:
+				return snprintf(text, size, "\nP%d: lock CPU mutex", e.taskId);
+			case TRACE_TASK_SUSPENDED:
+				return snprintf(text, size, "\nP%d: suspended, priority: %d.%02d", e.taskId, e.priority / 100, e.priority % 100);
+			case TRACE_TASK_RESUMED:
+				return snprintf(text, size, "\nP%d: resumed, executing, cnt: %d", e.taskId, e.arg);
+			case TRACE_TASK_TRY_LOCK:
+				return snprintf(text, size, "\nP%d: try CS%d lock", e.taskId, e.mutexId);
+			case TRACE_TASK_TRY_UNLOCK:
+				return snprintf(text, size, "\nP%d: try CS%d unlock", e.taskId, e.mutexId);
+			case TRACE_TASK_EXECUTED:
+				return snprintf(text, size, "\nP%d: executed, cnt: %d", e.taskId, e.arg);
+			case TRACE_TASK_COMPLETED:
+				return snprintf(text, size, "\nP%d: thread execution completed", e.taskId);
+			case TRACE_TASK_UNLOCK_CPU:
+				return snprintf(text, size, "\nP%d: unlock CPU mutex", e.taskId);
+
+			case TRACE_PC_LOCKING:
+				return snprintf(text, size, "\nPcMutex: locking CS%d, thread %d", e.mutexId, e.taskId);
+			case TRACE_PC_LOCK_ERROR:
+				return snprintf(text, size, "\nPcMutex: ERROR LOCKING MUTEX id: %d", e.mutexId);
+			case TRACE_PC_SAVE:
+				return snprintf(text, size, "\nPcMutex: saving thread %d state", e.taskId);
+			case TRACE_PC_SAVE_TARGET:
+				return snprintf(text, size, "\nPcMutex: saving thread %d state on target CS%d", e.taskId, e.mutexId);
+			case TRACE_PC_ALREADY_LOCKED:
+				return snprintf(text, size, "\nPcMutex: CS%d already locked by thread %d", e.mutexId, e.arg);
+			case TRACE_PC_SUSPEND:
+				return snprintf(text, size, "\nPcMutex: suspend thread %d", e.taskId);
+			case TRACE_PC_TRANSFER:
+				return snprintf(text, size, "\nPcMutex: transferring priority %d.%02d to thread %d", e.priority / 100, e.priority % 100, e.taskId);
+			case TRACE_PC_UNLOCKING:
+				return snprintf(text, size, "\nPcMutex: unlocking CS%d, recovering priorities, resuming suspended threads", e.mutexId);
+			case TRACE_PC_RECOVER:
+				return snprintf(text, size, "\nPcMutex: recovering thread %d priority to %d.%02d", e.taskId, e.priority / 100, e.priority % 100);
+			case TRACE_PC_RESET:
+				return snprintf(text, size, "\nPcMutex: resetting CS locked status");
+			case TRACE_PC_UNLOCK_ERROR:
+				return snprintf(text, size, "\nPcMutex: ERROR UNLOCKING MUTEX");
+			case TRACE_PC_DATA_HOLDER:
+				return snprintf(text, size, "\nPcMutex: creating thread %d data holder", e.taskId);
+
+			case TRACE_PI_LOCKING:
+				return snprintf(text, size, "\nPiMutex: locking CS");
+			case TRACE_PI_INHERIT_CS:
+				return snprintf(text, size, "\nPiMutex: inherit CS priority: %d.%02d", e.priority / 100, e.priority % 100);
+			case TRACE_PI_UPDATE_CS:
+				return snprintf(text, size, "\nPiMutex: update CS priority to: %d.%02d", e.priority / 100, e.priority % 100);
+			case TRACE_PI_ALREADY_LOCKED:
+				return snprintf(text, size, "\nPiMutex: CS already locked, inherit priority: %d.%02d", e.priority / 100, e.priority % 100);
+			case TRACE_PI_SUSPEND:
+				return snprintf(text, size, "\nPiMutex: suspend higher priority thread");
+			case TRACE_PI_IGNORE:
+				return snprintf(text, size, "\nPiMutex: ignoring locking attempts from lower priority threads");
+			case TRACE_PI_UNLOCKED:
+				return snprintf(text, size, "\nPiMutex: unlocked, recovering priorities, resuming suspended threads");
+
+			case TRACE_TASK_BLOCKED:
+				return snprintf(text, size, "\nP%d: blocked on CS%d", e.taskId, e.mutexId);
+			case TRACE_JOB_OVERRUN:
+				return snprintf(text, size, "\nP%d: previous job still active, release skipped", e.taskId);
+			case TRACE_DEADLINE_MISSED:
+				return snprintf(text, size, "\nP%d: deadline missed", e.taskId);
+
+			case TRACE_PI_PROPAGATE:
+				return snprintf(text, size, "\nPiMutex: propagating priority %d.%02d to thread %d (owner of CS%d)",
+						e.priority / 100, e.priority % 100, e.taskId, e.mutexId);
+
+			case TRACE_SRP_LOCKING:
+				return snprintf(text, size, "\nSrpMutex: locking CS%d, system ceiling %d.%02d", e.mutexId, e.priority / 100, e.priority % 100);
+			case TRACE_SRP_LOCK_ERROR:
+				return snprintf(text, size, "\nSrpMutex: ERROR LOCKING MUTEX id: %d", e.mutexId);
+			case TRACE_SRP_UNLOCKED:
+				return snprintf(text, size, "\nSrpMutex: unlocked CS%d, system ceiling %d.%02d", e.mutexId, e.priority / 100, e.priority % 100);
+			case TRACE_SRP_DEFER:
+				return snprintf(text, size, "\nSrpMutex: defer thread %d, preemption level %d.%02d <= system ceiling %d.%02d (CS%d)",
+						e.taskId, e.priority / 100, e.priority % 100, e.arg / 100, e.arg % 100, e.mutexId);
+			case TRACE_SRP_ADMIT:
+				return snprintf(text, size, "\nSrpMutex: admit thread %d, preemption level %d.%02d > system ceiling %d.%02d",
+						e.taskId, e.priority / 100, e.priority % 100, e.arg / 100, e.arg % 100);
+
+			case TRACE_PC_RAISE:
+				return snprintf(text, size, "\nPcMutex: raising thread %d priority to ceiling %d.%02d (CS%d)",
+						e.taskId, e.priority / 100, e.priority % 100, e.mutexId);
+
+			case TRACE_NP_LOCKING:
+				return snprintf(text, size, "\nMutex: locking CS%d, thread %d", e.mutexId, e.taskId);
+			case TRACE_NP_SUSPEND:
+				return snprintf(text, size, "\nMutex: CS%d already locked, suspend thread %d", e.mutexId, e.taskId);
+			case TRACE_NP_UNLOCKED:
+				return snprintf(text, size, "\nMutex: unlocked CS%d, resuming suspended threads", e.mutexId);
+
+			case TRACE_DEADLOCK_CYCLE:
+				return snprintf(text, size, "\nDeadlock: cycle %d closed by thread %d waiting for CS%d",
+						e.arg, e.taskId, e.mutexId);
+			case TRACE_DEADLOCK_EDGE:
+				return snprintf(text, size, "\nDeadlock: thread %d waits for CS%d held by thread %d",
+						e.taskId, e.mutexId, e.arg);
+			case TRACE_DEADLOCK_ABORT:
+				return snprintf(text, size, "\nScheduler: deadlock detected, terminate program at %d", e.arg);
+
+			default:
+				return snprintf(text, size, "\nunknown trace event %d", e.type);
+		}
+	}
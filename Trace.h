@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#ifndef Trace_h
+#define Trace_h
+
+// binary trace file identification
+#define TRACE_MAGIC "INVTRACE"
+#define TRACE_VERSION 1
+
+// events per thread ring buffer (power of 2)
+#define TRACE_BUFFER_SIZE 1024
+
+//-----------------------------------------------------------------------------------------
+// Trace event types (one per message of the simulation timeline).
+// Append only: the numeric values are stored in binary trace files.
+//-----------------------------------------------------------------------------------------
+enum TraceEventType
+{
+	// scheduler and thread manager
+	TRACE_SCHEDULER_LOCK = 1,		// Scheduler: lock CPU mutex
+	TRACE_SCHEDULER_UNLOCK,			// Scheduler: unlock CPU mutex
+	TRACE_RELEASE,					// P<task> released
+	TRACE_ACTIVATE,					// Thread manager: activate thread <task>
+	TRACE_NOTIFY,					// Thread manager: notify thread <task>
+	TRACE_TICK,						// timer tick: <arg>
+	TRACE_TICKS_MISSED,				// Scheduler: <arg> timer tick(s) missed
+	TRACE_TERMINATE,				// <arg> ticks are over, terminate program
+
+	// task threads
+	TRACE_TASK_LOCK_CPU,			// P<task>: lock CPU mutex
+	TRACE_TASK_SUSPENDED,			// P<task>: suspended, priority: <priority>
+	TRACE_TASK_RESUMED,				// P<task>: resumed, executing, cnt: <arg>
+	TRACE_TASK_TRY_LOCK,			// P<task>: try CS<mutex> lock
+	TRACE_TASK_TRY_UNLOCK,			// P<task>: try CS<mutex> unlock
+	TRACE_TASK_EXECUTED,			// P<task>: executed, cnt: <arg>
+	TRACE_TASK_COMPLETED,			// P<task>: thread execution completed
+	TRACE_TASK_UNLOCK_CPU,			// P<task>: unlock CPU mutex
+
+	// priority ceiling mutex
+	TRACE_PC_LOCKING,				// PcMutex: locking CS<mutex>, thread <task>
+	TRACE_PC_LOCK_ERROR,			// PcMutex: ERROR LOCKING MUTEX id: <mutex>
+	TRACE_PC_SAVE,					// PcMutex: saving thread <task> state
+	TRACE_PC_SAVE_TARGET,			// PcMutex: saving thread <task> state on target CS<mutex>
+	TRACE_PC_ALREADY_LOCKED,		// PcMutex: CS<mutex> already locked by thread <arg>
+	TRACE_PC_SUSPEND,				// PcMutex: suspend thread <task>
+	TRACE_PC_TRANSFER,				// PcMutex: transferring priority <priority> to thread <task>
+	TRACE_PC_UNLOCKING,				// PcMutex: unlocking CS<mutex>, recovering priorities, ...
+	TRACE_PC_RECOVER,				// PcMutex: recovering thread <task> priority to <priority>
+	TRACE_PC_RESET,					// PcMutex: resetting CS locked status
+	TRACE_PC_UNLOCK_ERROR,			// PcMutex: ERROR UNLOCKING MUTEX
+	TRACE_PC_DATA_HOLDER,			// PcMutex: creating thread <task> data holder
+
+	// priority inheritance mutex
+	TRACE_PI_LOCKING,				// PiMutex: locking CS
+	TRACE_PI_INHERIT_CS,			// PiMutex: inherit CS priority: <priority>
+	TRACE_PI_UPDATE_CS,				// PiMutex: update CS priority to: <priority>
+	TRACE_PI_ALREADY_LOCKED,		// PiMutex: CS already locked, inherit priority: <priority>
+	TRACE_PI_SUSPEND,				// PiMutex: suspend higher priority thread
+	TRACE_PI_IGNORE,				// PiMutex: ignoring locking attempts from lower priority threads
+	TRACE_PI_UNLOCKED,				// PiMutex: unlocked, recovering priorities, resuming ...
+
+	// task engine
+	TRACE_TASK_BLOCKED,				// P<task>: blocked on CS<mutex>
+	TRACE_JOB_OVERRUN,				// P<task>: previous job still active, release skipped
+	TRACE_DEADLINE_MISSED,			// P<task>: deadline missed
+
+	// priority inheritance mutex (transitive)
+	TRACE_PI_PROPAGATE,				// PiMutex: propagating priority <priority> to thread <task> (owner of CS<mutex>)
+
+	// stack resource policy mutex
+	TRACE_SRP_LOCKING,				// SrpMutex: locking CS<mutex>, system ceiling <priority>
+	TRACE_SRP_LOCK_ERROR,			// SrpMutex: ERROR LOCKING MUTEX id: <mutex>
+	TRACE_SRP_UNLOCKED,				// SrpMutex: unlocked CS<mutex>, system ceiling <priority>
+	TRACE_SRP_DEFER,				// SrpMutex: defer thread <task>, preemption level <priority> <= system ceiling <arg> (CS<mutex>)
+	TRACE_SRP_ADMIT,				// SrpMutex: admit thread <task>, preemption level <priority> > system ceiling <arg>
+
+	// priority ceiling mutex (immediate)
+	TRACE_PC_RAISE,					// PcMutex: raising thread <task> priority to ceiling <priority> (CS<mutex>)
+
+	// mutex without protocol (ProtocolMutex<NoProtocol>)
+	TRACE_NP_LOCKING,				// Mutex: locking CS<mutex>, thread <task>
+	TRACE_NP_SUSPEND,				// Mutex: CS<mutex> already locked, suspend thread <task>
+	TRACE_NP_UNLOCKED,				// Mutex: unlocked CS<mutex>, resuming suspended threads
+
+	// deadlock detector
+	TRACE_DEADLOCK_CYCLE,			// Deadlock: cycle <arg> closed by thread <task> waiting for CS<mutex>
+	TRACE_DEADLOCK_EDGE,			// Deadlock: thread <task> waits for CS<mutex> held by thread <arg>
+	TRACE_DEADLOCK_ABORT,			// Scheduler: deadlock detected, terminate program at <arg>
+
+	TRACE_EVENT_TYPES
+};
+
+//-----------------------------------------------------------------------------------------
+// Binary trace event (32 bytes). Sequence numbers give the global order across threads.
+//-----------------------------------------------------------------------------------------
+struct TraceEvent
+{
+	uint64_t sequence;
+	uint64_t timestamp;		// CLOCK_MONOTONIC, nanoseconds
+	uint16_t type;			// TraceEventType
+	uint16_t mutexId;		// resource ids are bounded by MAX_RESOURCE_ID (TaskSet.h)
+	int32_t taskId;
+	int32_t priority;
+	int32_t arg;			// event specific (owner thread, counter, tick)
+};
+
+//-----------------------------------------------------------------------------------------
+// Binary trace file header, followed by TraceEvent records in sequence order.
+//-----------------------------------------------------------------------------------------
+struct TraceFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t eventSize;
+};
+
+//-----------------------------------------------------------------------------------------
+// Single producer / single consumer ring of trace events, owned by one thread.
+// The owner only writes head, the drainer only writes tail (no locks on either side).
+//-----------------------------------------------------------------------------------------
+struct TraceBuffer
+{
+	alignas(64) std::atomic<uint32_t> head;		// next slot to write (producer)
+	alignas(64) std::atomic<uint32_t> tail;		// next slot to read (drainer)
+	alignas(64) std::atomic<bool> retired;		// owning thread exited
+	TraceBuffer *next;							// registry link
+	TraceEvent events[TRACE_BUFFER_SIZE];
+};
+
+//-----------------------------------------------------------------------------------------
+// Trace class definition.
+// Threads record compact binary events into their own ring buffer, a background drainer
+// merges them in sequence order and writes them either as binary records (to a file,
+// decoded offline with tracedump) or as the human readable timeline (to stdout).
+//-----------------------------------------------------------------------------------------
+class Trace
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		// starts the drainer, writes binary trace to path (or text to stdout if NULL)
+		static int start(const char* path);
+
+		// drains remaining events and stops the drainer
+		static void stop();
+
+		// records one event into the calling thread's buffer
+		static void record(int type, int taskId, int mutexId, int priority, int arg);
+
+		// formats event as timeline text, returns number of characters written
+		static int format(const TraceEvent& event, char* text, size_t size);
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <errno.h>
+#include <sched.h>
+
+#ifdef __QNX__
+#include <sys/neutrino.h>
+#endif
+
+#include "Log.h"
+#include "WorkerPool.h"
+
+//---------------------------------------------------------------------------------------------
+// WorkerPool class implementation.
+//---------------------------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------------------
+	// Constructor
+	//-----------------------------------------------------------------------------------------
+	WorkerPool::WorkerPool(int size, int cpu)
+	{
+		pthread_mutex_init(&mutex, NULL);
+		idle = NULL;
+		this->size = 0;
+		this->cpu = cpu;
+
+		pthread_mutex_lock(&mutex);
+		for (int i = 0; i < size; i++)
+		{
+			Worker *worker = createWorker();
+			if (worker == NULL)
+				break;
+			worker->next = idle;
+			idle = worker;
+		}
+		pthread_mutex_unlock(&mutex);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Binds function to an idle worker (grows the pool if there is none) and wakes it up.
+	//-----------------------------------------------------------------------------------------
+	void WorkerPool::run(void* (*function)(void*), void* arg)
+	{
+		pthread_mutex_lock(&mutex);
+
+		Worker *worker = idle;
+		if (worker != NULL)
+			idle = worker->next;
+		else
+		{
+			LOG_PRINT(LOG_DEBUG, "WorkerPool: all %d workers busy, adding one\n", size);
+			worker = createWorker();
+			if (worker == NULL)
+			{
+				Log<LOG_ERROR>::print("WorkerPool: error creating worker\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		worker->function = function;
+		worker->arg = arg;
+		pthread_cond_signal(&worker->wakeup);
+
+		pthread_mutex_unlock(&mutex);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Returns number of worker threads.
+	//-----------------------------------------------------------------------------------------
+	int WorkerPool::getSize()
+	{
+		return size;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Pins the calling thread to cpu.
+	//-----------------------------------------------------------------------------------------
+	int WorkerPool::pin(int cpu)
+	{
+#ifdef __QNX__
+		if (ThreadCtl(_NTO_TCTL_RUNMASK, (void*) (1 << cpu)) == -1)
+			return errno;
+		return 0;
+#else
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Creates one (not idle) worker thread.
+	//-----------------------------------------------------------------------------------------
+	WorkerPool::Worker* WorkerPool::createWorker()
+	{
+		Worker *worker = new Worker;
+		worker->pool = this;
+		worker->function = NULL;
+		worker->arg = NULL;
+		worker->next = NULL;
+		pthread_cond_init(&worker->wakeup, NULL);
+
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		int result = pthread_create(&worker->thread, &attr, work, worker);
+		pthread_attr_destroy(&attr);
+		if (result != 0)
+		{
+			pthread_cond_destroy(&worker->wakeup);
+			delete worker;
+			return NULL;
+		}
+
+		size++;
+		return worker;
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Worker thread: waits for a bound job, runs it, goes back to the idle list.
+	//-----------------------------------------------------------------------------------------
+	void* WorkerPool::work(void* arg)
+	{
+		Worker *worker = (Worker*) arg;
+		WorkerPool *pool = worker->pool;
+
+		if (pool->cpu != NO_CPU && pin(pool->cpu) != 0)
+			Log<LOG_ERROR>::print("WorkerPool: error pinning worker to CPU %d\n", pool->cpu);
+
+		pthread_mutex_lock(&pool->mutex);
+		while (1)
+		{
+			while (worker->function == NULL)
+				pthread_cond_wait(&worker->wakeup, &pool->mutex);
+
+			void* (*function)(void*) = worker->function;
+			void *functionArg = worker->arg;
+			pthread_mutex_unlock(&pool->mutex);
+
+			function(functionArg);
+
+			pthread_mutex_lock(&pool->mutex);
+			worker->function = NULL;
+			worker->next = pool->idle;
+			pool->idle = worker;
+		}
+
+		return NULL;
+	}
@@ -0,0 +1,67 @@
+#include <pthread.h>
+
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#define NO_CPU -1		// workers are not pinned
+
+//-----------------------------------------------------------------------------------------
+// WorkerPool class definition.
+// Threads created ahead of time and reused for jobs: run() binds a function to an idle
+// worker (the last one that became idle, its stack is still warm) and wakes it up. When
+// all workers are busy the pool grows by one thread. Workers optionally run on one CPU
+// and live until the process exits.
+//-----------------------------------------------------------------------------------------
+class WorkerPool
+{
+	//-----------------------------------------------------------------------------------------
+	// Worker thread state
+	//-----------------------------------------------------------------------------------------
+	struct Worker
+	{
+		WorkerPool *pool;
+		pthread_t thread;
+		pthread_cond_t wakeup;
+		void* (*function)(void*);	// bound job, NULL while idle
+		void* arg;
+		Worker *next;				// idle list link
+	};
+
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		// constructor, starts size workers (pinned to cpu unless NO_CPU)
+		WorkerPool(int size, int cpu = NO_CPU);
+
+		// runs function(arg) on an idle worker
+		void run(void* (*function)(void*), void* arg);
+
+		// returns number of worker threads
+		int getSize();
+
+		// pins the calling thread to cpu, returns 0 (success) or an error number
+		static int pin(int cpu);
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		pthread_mutex_t mutex;
+		Worker *idle;				// idle workers, most recently idle first
+		int size;
+		int cpu;
+
+	//-----------------------------------------------------------------------------------------
+	// Protected members
+	//-----------------------------------------------------------------------------------------
+	protected:
+
+		// creates one worker (pool mutex held), returns NULL on failure
+		Worker* createWorker();
+
+		// worker thread: runs bound jobs
+		static void* work(void* arg);
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+#ifndef bench_h
+#define bench_h
+
+//-----------------------------------------------------------------------------------------
+// Returns CLOCK_MONOTONIC time in nanoseconds.
+//-----------------------------------------------------------------------------------------
+inline long long nowNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------------------
+// Latency samples collector (nanoseconds) with mean and percentile reporting.
+//-----------------------------------------------------------------------------------------
+class LatencyRecorder
+{
+	//-----------------------------------------------------------------------------------------
+	// Public members
+	//-----------------------------------------------------------------------------------------
+	public:
+		//-----------------------------------------------------------------------------------------
+		// Constructor (preallocates sample storage, so recording does not allocate)
+		//-----------------------------------------------------------------------------------------
+		LatencyRecorder(size_t capacity)
+		{
+			samples.reserve(capacity);
+			sorted = true;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Records one sample.
+		//-----------------------------------------------------------------------------------------
+		void add(long long sample)
+		{
+			samples.push_back(sample);
+			sorted = false;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Appends samples of another recorder (e.g. one per thread).
+		//-----------------------------------------------------------------------------------------
+		void merge(const LatencyRecorder& other)
+		{
+			samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+			sorted = false;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the p-th percentile (0 < p <= 100) of recorded samples.
+		//-----------------------------------------------------------------------------------------
+		long long percentile(double p)
+		{
+			if (samples.empty())
+				return 0;
+
+			if (!sorted)
+			{
+				std::sort(samples.begin(), samples.end());
+				sorted = true;
+			}
+
+			size_t index = (size_t) (p / 100.0 * (samples.size() - 1) + 0.5);
+			return samples[index];
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns the arithmetic mean of recorded samples.
+		//-----------------------------------------------------------------------------------------
+		double mean()
+		{
+			if (samples.empty())
+				return 0;
+
+			double sum = 0;
+			for (size_t i = 0; i < samples.size(); i++)
+				sum += samples[i];
+
+			return sum / samples.size();
+		}
+
+		//-----------------------------------------------------------------------------------------
+		// Returns number of recorded samples.
+		//-----------------------------------------------------------------------------------------
+		size_t count()
+		{
+			return samples.size();
+		}
+
+	//-----------------------------------------------------------------------------------------
+	// Private members
+	//-----------------------------------------------------------------------------------------
+	private:
+		std::vector<long long> samples;
+		bool sorted;
+};
+
+#endif
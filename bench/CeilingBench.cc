@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "../PcMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// System ceiling benchmark.
+// One task locks and unlocks a mutex while [depth] other mutexes of a large set are
+// held (nested critical sections). PcMutex::lock reads the system ceiling from the
+// ceiling stack, so its latency should not grow with the number of mutexes. The scan
+// column is the cost of the previous approach (walking the whole mutex array).
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 CeilingBench.cc ../Trace.cc ../Profile.cc -lpthread
+//
+// usage: CeilingBench [mutexes] [iterations]
+//=============================================================================
+
+PcMutex* volatile sink;		// keeps the scan loop from being optimized away
+
+//-----------------------------------------------------------------------------------------
+// Returns the last locked mutex of the array (what the previous lock path computed).
+//-----------------------------------------------------------------------------------------
+PcMutex* scan(PcMutex pcMutexes[], int size)
+{
+	PcMutex *lockedMutex = NULL;
+	for (int i = 0; i < size; i++)
+	{
+		if (pcMutexes[i].isLocked())
+			lockedMutex = &pcMutexes[i];
+	}
+
+	return lockedMutex;
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int size = (argc > 1) ? atoi(argv[1]) : 10000;
+	int iterations = (argc > 2) ? atoi(argv[2]) : 10000;
+	if (size < 2 || iterations < 1)
+	{
+		fprintf(stderr, "usage: CeilingBench [mutexes > 1] [iterations > 0]\n");
+		return 1;
+	}
+
+	ReadyQueue queue(2);
+	queue.insert(1, 50);
+
+	PcMutex* pcMutex = new PcMutex[size];
+	for (int i = 0; i < size; i++)
+	{
+		pcMutex[i].setId(i + 1);
+		pcMutex[i].setCsPriority(60);
+	}
+
+	printf("%d mutexes, %d iterations\n", size, iterations);
+	printf("%8s %12s %12s %12s\n", "depth", "lock p50", "lock p99", "scan mean");
+
+	int held = 0;
+	for (int depth = 0; depth < size; depth = (depth == 0) ? 1 : depth * 10)
+	{
+		// nest critical sections up to depth (spread over the array)
+		while (held < depth)
+		{
+			pcMutex[(long long) held * (size - 1) / depth].lock(1, &queue);
+			held++;
+		}
+
+		PcMutex *target = &pcMutex[size - 1];
+		LatencyRecorder lockLatency(iterations);
+		for (int i = 0; i < iterations; i++)
+		{
+			long long start = nowNs();
+			target->lock(1, &queue);
+			lockLatency.add(nowNs() - start);
+			target->unlock(&queue);
+		}
+
+		long long start = nowNs();
+		for (int i = 0; i < iterations; i++)
+			sink = scan(pcMutex, size);
+		double scanMean = (double) (nowNs() - start) / iterations;
+
+		printf("%8d %9lld ns %9lld ns %9.0f ns\n", depth, lockLatency.percentile(50),
+				lockLatency.percentile(99), scanMean);
+
+		// release in LIFO order before the next round
+		while (held > 0)
+		{
+			held--;
+			pcMutex[(long long) held * (size - 1) / depth].unlock(&queue);
+		}
+	}
+
+	delete[] pcMutex;
+	return 0;
+}
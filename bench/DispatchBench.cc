@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "Bench.h"
+
+//=============================================================================
+// Dispatch latency benchmark.
+// A manager thread repeatedly selects one of N parked task threads and wakes it up, the
+// task acknowledges and parks again (same handshake as threadManager in inversion.cc).
+// Compares a single broadcast condition variable with per-task wait slots.
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 DispatchBench.cc -lpthread
+//
+// usage: DispatchBench [rounds]
+//=============================================================================
+
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t cond = PTHREAD_COND_INITIALIZER;		// shared condition (broadcast mode)
+pthread_cond_t ack = PTHREAD_COND_INITIALIZER;		// task -> manager acknowledgement
+pthread_cond_t* taskCond = NULL;					// per-task wait slots (targeted mode)
+
+int active_p = 0;			// task selected by the manager (0 = none)
+bool acknowledged = false;	// selected task resumed
+bool targeted = false;		// wake only the selected task
+bool stop = false;			// terminate task threads
+
+//-----------------------------------------------------------------------------------------
+// Task thread: waits until selected, acknowledges, parks again.
+//-----------------------------------------------------------------------------------------
+void* task(void* arg)
+{
+	int id = (int) (long) arg;
+
+	pthread_mutex_lock(&mutex);
+	while (1)
+	{
+		while (active_p != id && !stop)
+			pthread_cond_wait(targeted ? &taskCond[id] : &cond, &mutex);
+
+		if (stop)
+			break;
+
+		active_p = 0;
+		acknowledged = true;
+		pthread_cond_signal(&ack);
+	}
+	pthread_mutex_unlock(&mutex);
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------------------
+// Runs one configuration, prints dispatch latency (select -> task acknowledged).
+//-----------------------------------------------------------------------------------------
+void run(int taskCount, bool targetedMode, int rounds)
+{
+	targeted = targetedMode;
+	stop = false;
+	active_p = 0;
+
+	taskCond = new pthread_cond_t[taskCount + 1];
+	for (int i = 0; i <= taskCount; i++)
+		pthread_cond_init(&taskCond[i], NULL);
+
+	pthread_t* threads = new pthread_t[taskCount + 1];
+	for (int i = 1; i <= taskCount; i++)
+		pthread_create(&threads[i], NULL, task, (void*) (long) i);
+
+	LatencyRecorder latency(rounds);
+	for (int r = 0; r < rounds; r++)
+	{
+		int target = 1 + (r * 7919) % taskCount;
+
+		pthread_mutex_lock(&mutex);
+		long long start = nowNs();
+
+		active_p = target;
+		acknowledged = false;
+		if (targeted)
+			pthread_cond_signal(&taskCond[target]);
+		else
+			pthread_cond_broadcast(&cond);
+
+		while (!acknowledged)
+			pthread_cond_wait(&ack, &mutex);
+
+		latency.add(nowNs() - start);
+		pthread_mutex_unlock(&mutex);
+	}
+
+	pthread_mutex_lock(&mutex);
+	stop = true;
+	pthread_cond_broadcast(&cond);
+	for (int i = 1; i <= taskCount; i++)
+		pthread_cond_signal(&taskCond[i]);
+	pthread_mutex_unlock(&mutex);
+
+	for (int i = 1; i <= taskCount; i++)
+		pthread_join(threads[i], NULL);
+
+	printf("%-10s %6d %10.0f %10lld %10lld\n", targeted ? "targeted" : "broadcast",
+			taskCount, latency.mean(), latency.percentile(50), latency.percentile(99));
+
+	for (int i = 0; i <= taskCount; i++)
+		pthread_cond_destroy(&taskCond[i]);
+	delete[] taskCond;
+	delete[] threads;
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int rounds = (argc > 1) ? atoi(argv[1]) : 2000;
+	int taskCounts[] = {3, 10, 100, 1000};
+
+	printf("%-10s %6s %10s %10s %10s\n", "mode", "tasks", "mean(ns)", "p50(ns)", "p99(ns)");
+	for (int i = 0; i < 4; i++)
+	{
+		run(taskCounts[i], false, rounds);
+		run(taskCounts[i], true, rounds);
+	}
+
+	return 0;
+}
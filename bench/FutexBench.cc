@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "Bench.h"
+#include "../Mutex.h"
+#include "../PiMutex.h"
+#include "../FutexPiMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// Futex PI mutex benchmark.
+// 1 to 64 threads repeatedly lock a shared mutex, increment a counter and unlock.
+// Compares the plain Mutex wrapper, PiMutex (native PTHREAD_PRIO_INHERIT, the emulated
+// one cannot block real threads) and FutexPiMutex. Reports throughput and the time per
+// lock/unlock pair. The uncontended cost of the emulated PiMutex is printed first.
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 FutexBench.cc ../Trace.cc ../Profile.cc -lpthread
+//
+// usage: FutexBench [operations per thread]
+//=============================================================================
+
+#define MAX_THREADS 64
+
+enum MutexType { MUTEX_PLAIN, MUTEX_PI, MUTEX_FUTEX_PI, MUTEX_TYPES };
+const char* names[MUTEX_TYPES] = { "Mutex", "PiMutex (native)", "FutexPiMutex" };
+
+Mutex* mutex;
+PiMutex* piMutex;
+FutexPiMutex* futexPiMutex;
+
+int type = MUTEX_PLAIN;		// mutex under test
+int operations = 0;			// lock/unlock pairs per thread
+long counter = 0;			// protected by the mutex under test
+long long start = 0;		// time all threads passed the barrier
+
+pthread_barrier_t barrier;
+
+//-----------------------------------------------------------------------------------------
+// Contending thread
+//-----------------------------------------------------------------------------------------
+void* contend(void* arg)
+{
+	int id = (int) (long) arg;
+	if (pthread_barrier_wait(&barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+		start = nowNs();
+
+	for (int i = 0; i < operations; i++)
+	{
+		switch (type)
+		{
+			case MUTEX_PLAIN:
+				mutex->lock();
+				counter++;
+				mutex->unlock();
+				break;
+
+			case MUTEX_PI:
+				piMutex->lock(id, NULL);
+				counter++;
+				piMutex->unlock(id, NULL);
+				break;
+
+			case MUTEX_FUTEX_PI:
+				futexPiMutex->lock();
+				counter++;
+				futexPiMutex->unlock();
+				break;
+		}
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------------------
+// Runs threads contending for the mutex under test, returns elapsed time (ns).
+//-----------------------------------------------------------------------------------------
+long long run(int threads)
+{
+	pthread_t thread[MAX_THREADS];
+	pthread_barrier_init(&barrier, NULL, threads);
+	counter = 0;
+
+	for (int i = 0; i < threads; i++)
+		pthread_create(&thread[i], NULL, contend, (void*) (long) (i + 1));
+
+	for (int i = 0; i < threads; i++)
+		pthread_join(thread[i], NULL);
+	long long elapsed = nowNs() - start;
+
+	pthread_barrier_destroy(&barrier);
+	if (counter != (long) threads * operations)
+	{
+		fprintf(stderr, "%s: counter %ld, expected %ld\n", names[type], counter, (long) threads * operations);
+		exit(1);
+	}
+
+	return elapsed;
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	operations = (argc > 1) ? atoi(argv[1]) : 100000;
+
+	mutex = new Mutex();
+	piMutex = new PiMutex();
+	futexPiMutex = new FutexPiMutex();
+
+	// uncontended emulated PiMutex (simulator path) for reference
+	ReadyQueue queue(2);
+	queue.insert(1, 50);
+	start = nowNs();
+	for (int i = 0; i < operations; i++)
+	{
+		piMutex->lock(1, &queue);
+		piMutex->unlock(1, &queue);
+	}
+	printf("PiMutex (emulated), uncontended: %.1f ns/op\n\n", (double) (nowNs() - start) / operations);
+
+	if (piMutex->setNative(true) != 0)
+		return 1;
+
+	printf("%8s", "threads");
+	for (int i = 0; i < MUTEX_TYPES; i++)
+		printf(" %26s", names[i]);
+	printf("\n");
+
+	for (int threads = 1; threads <= MAX_THREADS; threads *= 2)
+	{
+		printf("%8d", threads);
+		for (type = 0; type < MUTEX_TYPES; type++)
+		{
+			long long elapsed = run(threads);
+			double total = (double) threads * operations;
+			printf(" %9.2f Mop/s %7.1f ns/op", total / elapsed * 1000, (double) elapsed / total);
+		}
+		printf("\n");
+	}
+
+	delete mutex;
+	delete piMutex;
+	delete futexPiMutex;
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <list>
+
+#include "Bench.h"
+#include "../History.h"
+#include "../PiMutex.h"
+#include "../PcMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// Mutex history benchmark.
+// Counts heap allocations (global operator new, also used for history pool chunks) and measures
+// latency of the lock/donate/unlock pattern of the mutexes, first on the saved state
+// containers alone (std::list against History), then on PiMutex and PcMutex.
+// Exits with status 1 if the mutexes allocate once warmed up.
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 HistoryBench.cc ../Trace.cc ../Profile.cc -lpthread
+//
+// usage: HistoryBench [iterations]
+//=============================================================================
+
+long allocations = 0;		// global operator new calls
+
+void* operator new(size_t size)
+{
+	allocations++;
+	void *memory = malloc(size);
+	if (memory == NULL)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+struct ThreadInfo
+{
+	int threadId;
+	int nativePriority;
+};
+
+//-----------------------------------------------------------------------------------------
+// One mutex cycle: owner state, two donors (suspended threads), recovery on unlock.
+//-----------------------------------------------------------------------------------------
+template <typename Container>
+void cycle(Container& history)
+{
+	for (int id = 1; id <= 3; id++)
+	{
+		ThreadInfo info;
+		info.threadId = id;
+		info.nativePriority = 10 * id;
+		history.push_front(info);
+	}
+
+	volatile int owner = history.back().threadId;
+	(void) owner;
+
+	while (!history.empty())
+		history.pop_front();
+}
+
+//-----------------------------------------------------------------------------------------
+// Prints latency and allocations per operation.
+//-----------------------------------------------------------------------------------------
+void report(const char* name, long long start, long allocated, int iterations)
+{
+	fprintf(stderr, "%-32s %8.1f ns/op %8.3f alloc/op\n", name, (double) (nowNs() - start) / iterations,
+			(double) allocated / iterations);
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int iterations = (argc > 1) ? atoi(argv[1]) : 1000000;
+
+	std::list<ThreadInfo> list;
+	long before = allocations;
+	long long start = nowNs();
+	for (int i = 0; i < iterations; i++)
+		cycle(list);
+	report("std::list history", start, allocations - before, iterations);
+
+	History<ThreadInfo> history;
+	before = allocations;
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+		cycle(history);
+	report("History (pool)", start, allocations - before, iterations);
+
+	// task 1 owns the mutex, tasks 2 and 3 are suspended on it with higher priorities
+	ReadyQueue queue(4);
+	queue.insert(1, 10);
+	queue.insert(2, 20);
+	queue.insert(3, 30);
+
+	// warm up with a full contended cycle: history pool chunk, per-thread state of ids 1..3
+	PiMutex piMutex;
+	piMutex.lock(1, &queue);
+	piMutex.lock(2, &queue);
+	piMutex.lock(3, &queue);
+	piMutex.unlock(1, &queue);
+	before = allocations;
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		piMutex.lock(1, &queue);
+		piMutex.lock(2, &queue);
+		piMutex.lock(3, &queue);
+		piMutex.unlock(1, &queue);
+	}
+	long piAllocated = allocations - before;
+	report("PiMutex lock/donate/unlock", start, piAllocated, iterations);
+
+	PcMutex pcMutex;
+	pcMutex.setCsPriority(30);
+	pcMutex.lock(1, &queue);
+	pcMutex.lock(2, &queue);
+	pcMutex.lock(3, &queue);
+	pcMutex.unlock(&queue);
+	before = allocations;
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		pcMutex.lock(1, &queue);
+		pcMutex.lock(2, &queue);
+		pcMutex.lock(3, &queue);
+		pcMutex.unlock(&queue);
+	}
+	long pcAllocated = allocations - before;
+	report("PcMutex lock/donate/unlock", start, pcAllocated, iterations);
+
+	if (piAllocated != 0 || pcAllocated != 0)
+	{
+		fprintf(stderr, "FAILED: mutex steady state allocates\n");
+		return 1;
+	}
+
+	return 0;
+}
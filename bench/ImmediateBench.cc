@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "../PcMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// Original vs immediate priority ceiling benchmark (emulated PcMutex).
+// uncontended: one task locks and unlocks a mutex while another task holds [depth]
+//   nested mutexes of lower ceiling (the original protocol compares against the system
+//   ceiling and saves state, the immediate one raises the caller to the ceiling).
+// blocked: a task whose priority is not above the system ceiling (the other task holds a
+//   mutex of ceiling 60) tries the lock. The original protocol suspends it and transfers
+//   its priority to the holder (one context switch more in the simulator). The immediate
+//   one never gets there because the holder runs at the ceiling, its column repeats the
+//   uncontended lock.
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 ImmediateBench.cc ../Trace.cc ../Profile.cc -lpthread
+//
+// usage: ImmediateBench [iterations]
+//=============================================================================
+
+//-----------------------------------------------------------------------------------------
+// Returns lock + unlock latency recorder of task 1 on target while task 2 holds
+// depth other mutexes.
+//-----------------------------------------------------------------------------------------
+LatencyRecorder* measure(PcMutex pcMutex[], int depth, bool immediate, int iterations)
+{
+	ReadyQueue queue(3);
+	queue.insert(1, 55);
+	queue.insert(2, 40);
+
+	for (int i = 0; i <= depth; i++)
+		pcMutex[i].setImmediate(immediate);
+	for (int i = 1; i <= depth; i++)
+		pcMutex[i].lock(2, &queue);
+
+	LatencyRecorder *latency = new LatencyRecorder(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		long long start = nowNs();
+		pcMutex[0].lock(1, &queue);
+		pcMutex[0].unlock(&queue);
+		latency->add(nowNs() - start);
+	}
+
+	for (int i = depth; i >= 1; i--)
+		pcMutex[i].unlock(&queue);
+	return latency;
+}
+
+//-----------------------------------------------------------------------------------------
+// Returns latency recorder of a lock attempt blocked by the system ceiling (original
+// protocol: suspend and transfer), including the holder's unlock that resumes it.
+//-----------------------------------------------------------------------------------------
+LatencyRecorder* measureBlocked(PcMutex pcMutex[], int iterations)
+{
+	ReadyQueue queue(3);
+	queue.insert(1, 55);
+	queue.insert(2, 40);
+	pcMutex[0].setImmediate(false);
+	pcMutex[1].setImmediate(false);
+	pcMutex[1].setCsPriority(60);
+
+	LatencyRecorder *latency = new LatencyRecorder(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		pcMutex[1].lock(2, &queue);
+
+		long long start = nowNs();
+		pcMutex[0].lock(1, &queue);
+		pcMutex[1].unlock(&queue);
+		latency->add(nowNs() - start);
+	}
+
+	pcMutex[1].setCsPriority(50);
+	return latency;
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int iterations = (argc > 1) ? atoi(argv[1]) : 100000;
+	if (iterations < 1)
+	{
+		fprintf(stderr, "usage: ImmediateBench [iterations > 0]\n");
+		return 1;
+	}
+
+	// mutex 0 (ceiling 60) is used by task 1 (priority 55), the others (ceiling 50) by
+	// task 2 (priority 40)
+	PcMutex pcMutex[11];
+	for (int i = 0; i < 11; i++)
+	{
+		pcMutex[i].setId(i + 1);
+		pcMutex[i].setCsPriority((i == 0) ? 60 : 50);
+	}
+
+	printf("%d iterations (lock + unlock)\n", iterations);
+	printf("%-14s %12s %12s %12s %12s\n", "case", "orig p50", "orig p99", "imm p50", "imm p99");
+
+	int depths[] = { 0, 1, 10 };
+	for (int d = 0; d < 3; d++)
+	{
+		LatencyRecorder *original = measure(pcMutex, depths[d], false, iterations);
+		LatencyRecorder *immediate = measure(pcMutex, depths[d], true, iterations);
+
+		char name[32];
+		snprintf(name, sizeof(name), "held %d", depths[d]);
+		printf("%-14s %9lld ns %9lld ns %9lld ns %9lld ns\n", name, original->percentile(50),
+				original->percentile(99), immediate->percentile(50), immediate->percentile(99));
+		delete original;
+		delete immediate;
+	}
+
+	LatencyRecorder *blocked = measureBlocked(pcMutex, iterations);
+	LatencyRecorder *immediate = measure(pcMutex, 0, true, iterations);
+	printf("%-14s %9lld ns %9lld ns %9lld ns %9lld ns\n", "blocked", blocked->percentile(50),
+			blocked->percentile(99), immediate->percentile(50), immediate->percentile(99));
+	delete blocked;
+	delete immediate;
+
+	return 0;
+}
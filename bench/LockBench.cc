@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <atomic>
+#include <vector>
+
+#include "Bench.h"
+#include "../Mutex.h"
+#include "../PiMutex.h"
+#include "../PcMutex.h"
+#include "../FutexPiMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// Lock microbenchmark suite.
+// Mutexes: mutex, mutex-spin (adaptive), pi, pc (emulated), pi-native, pc-native, futex-pi.
+//  uncontended: lock/unlock latency of one thread cycling over [mutexes] mutexes;
+//  contended:   [threads] threads locking [mutexes] mutexes in turn, holding each for
+//               [cs] ns; reports throughput and lock acquisition latency;
+//  handoff:     time from unlock by the owner to lock return in a blocked waiter.
+// Every result row (p50/p99/p99.9 and throughput) is also written to a CSV file, so runs
+// of different versions can be compared.
+// The emulated PiMutex and PcMutex never block (the simulator retries), so they only take
+// part in the uncontended benchmark; contended and handoff use the native modes.
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 LockBench.cc ../Trace.cc ../Profile.cc -lpthread
+//
+// usage: LockBench [-t threads,...] [-c cs_ns,...] [-m mutexes,...] [-n ops] [-r rounds]
+//                  [-o file.csv]
+//=============================================================================
+
+enum LockType
+{
+	LOCK_MUTEX,			// Mutex
+	LOCK_MUTEX_ADAPTIVE,	// Mutex (adaptive spin then park)
+	LOCK_PI,			// PiMutex (emulated)
+	LOCK_PC,			// PcMutex (emulated)
+	LOCK_PI_NATIVE,		// PiMutex (PTHREAD_PRIO_INHERIT)
+	LOCK_PC_NATIVE,		// PcMutex (PTHREAD_PRIO_PROTECT)
+	LOCK_FUTEX_PI,		// FutexPiMutex
+	LOCK_TYPES
+};
+
+const char* lockNames[LOCK_TYPES] = { "mutex", "mutex-spin", "pi", "pc", "pi-native", "pc-native", "futex-pi" };
+const bool lockBlocks[LOCK_TYPES] = { true, true, false, false, true, true, true };
+
+#define CEILING 50			// PcMutex ceiling and emulated task priority
+#define HANDOFF_SLEEP_US 50	// owner waits for the waiter to block
+
+// mutexes under test (one array is allocated, depending on the type)
+int lockType = LOCK_MUTEX;
+int lockCount = 0;
+Mutex* mutexes = NULL;
+PiMutex* piMutexes = NULL;
+PcMutex* pcMutexes = NULL;
+FutexPiMutex* futexPiMutexes = NULL;
+ReadyQueue queue(3);
+
+FILE* csv = NULL;
+
+//-----------------------------------------------------------------------------------------
+// Allocates count mutexes of the given type.
+//-----------------------------------------------------------------------------------------
+void createLocks(int type, int count)
+{
+	lockType = type;
+	lockCount = count;
+	switch (type)
+	{
+		case LOCK_MUTEX:
+		case LOCK_MUTEX_ADAPTIVE:
+			mutexes = new Mutex[count];
+			for (int i = 0; i < count; i++)
+				mutexes[i].setAdaptive(type == LOCK_MUTEX_ADAPTIVE);
+			break;
+
+		case LOCK_PI:
+		case LOCK_PI_NATIVE:
+			piMutexes = new PiMutex[count];
+			for (int i = 0; i < count; i++)
+			{
+				piMutexes[i].setId(i + 1);
+				piMutexes[i].setNative(type == LOCK_PI_NATIVE);
+			}
+			break;
+
+		case LOCK_PC:
+		case LOCK_PC_NATIVE:
+			pcMutexes = new PcMutex[count];
+			for (int i = 0; i < count; i++)
+			{
+				pcMutexes[i].setId(i + 1);
+				pcMutexes[i].setCsPriority(CEILING);
+				pcMutexes[i].setNative(type == LOCK_PC_NATIVE);
+			}
+			break;
+
+		case LOCK_FUTEX_PI:
+			futexPiMutexes = new FutexPiMutex[count];
+			break;
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Frees the mutexes under test.
+//-----------------------------------------------------------------------------------------
+void destroyLocks()
+{
+	delete[] mutexes;
+	delete[] piMutexes;
+	delete[] pcMutexes;
+	delete[] futexPiMutexes;
+	mutexes = NULL;
+	piMutexes = NULL;
+	pcMutexes = NULL;
+	futexPiMutexes = NULL;
+}
+
+//-----------------------------------------------------------------------------------------
+// Locks mutex index on behalf of task.
+//-----------------------------------------------------------------------------------------
+inline void lockAt(int index, int task)
+{
+	switch (lockType)
+	{
+		case LOCK_MUTEX: case LOCK_MUTEX_ADAPTIVE: mutexes[index].lock(); break;
+		case LOCK_PI: case LOCK_PI_NATIVE: piMutexes[index].lock(task, &queue); break;
+		case LOCK_PC: case LOCK_PC_NATIVE: pcMutexes[index].lock(task, &queue); break;
+		case LOCK_FUTEX_PI: futexPiMutexes[index].lock(); break;
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Unlocks mutex index on behalf of task.
+//-----------------------------------------------------------------------------------------
+inline void unlockAt(int index, int task)
+{
+	switch (lockType)
+	{
+		case LOCK_MUTEX: case LOCK_MUTEX_ADAPTIVE: mutexes[index].unlock(); break;
+		case LOCK_PI: case LOCK_PI_NATIVE: piMutexes[index].unlock(task, &queue); break;
+		case LOCK_PC: case LOCK_PC_NATIVE: pcMutexes[index].unlock(&queue); break;
+		case LOCK_FUTEX_PI: futexPiMutexes[index].unlock(); break;
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Busy waits for duration nanoseconds (critical section).
+//-----------------------------------------------------------------------------------------
+inline void spin(int duration)
+{
+	if (duration <= 0)
+		return;
+
+	long long end = nowNs() + duration;
+	while (nowNs() < end)
+		;
+}
+
+//-----------------------------------------------------------------------------------------
+// Prints one result row and appends it to the CSV file.
+//-----------------------------------------------------------------------------------------
+void report(const char* benchmark, int threads, int cs, long long elapsed, LatencyRecorder& latency)
+{
+	double throughput = (elapsed > 0) ? latency.count() * 1000.0 / elapsed : 0;
+
+	printf("%-12s %-10s %7d %7d %7d %9.3f %9lld %9lld %9lld\n", benchmark, lockNames[lockType], threads,
+			cs, lockCount, throughput, latency.percentile(50), latency.percentile(99),
+			latency.percentile(99.9));
+
+	if (csv != NULL)
+		fprintf(csv, "%s,%s,%d,%d,%d,%ld,%.3f,%.1f,%lld,%lld,%lld\n", benchmark, lockNames[lockType],
+				threads, cs, lockCount, (long) latency.count(), throughput, latency.mean(),
+				latency.percentile(50), latency.percentile(99), latency.percentile(99.9));
+}
+
+//-----------------------------------------------------------------------------------------
+// Uncontended lock/unlock latency, one thread cycling over all mutexes.
+//-----------------------------------------------------------------------------------------
+void uncontended(int ops)
+{
+	LatencyRecorder latency(ops);
+	long long start = nowNs();
+	for (int i = 0; i < ops; i++)
+	{
+		int index = i % lockCount;
+		long long begin = nowNs();
+		lockAt(index, 1);
+		unlockAt(index, 1);
+		latency.add(nowNs() - begin);
+	}
+
+	report("uncontended", 1, 0, nowNs() - start, latency);
+}
+
+//-----------------------------------------------------------------------------------------
+// Contended benchmark state
+//-----------------------------------------------------------------------------------------
+struct Worker
+{
+	pthread_t thread;
+	int id;
+	int ops;
+	int cs;
+	LatencyRecorder* latency;		// lock acquisition latency
+};
+
+pthread_barrier_t barrier;
+long long contendedStart = 0;
+
+//-----------------------------------------------------------------------------------------
+// Contending thread: locks the mutexes in turn, starting at its own index.
+//-----------------------------------------------------------------------------------------
+void* contend(void* arg)
+{
+	Worker *worker = (Worker*) arg;
+	if (pthread_barrier_wait(&barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+		contendedStart = nowNs();
+
+	for (int i = 0; i < worker->ops; i++)
+	{
+		int index = (worker->id + i) % lockCount;
+		long long begin = nowNs();
+		lockAt(index, worker->id);
+		worker->latency->add(nowNs() - begin);
+		spin(worker->cs);
+		unlockAt(index, worker->id);
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------------------
+// Contended throughput and acquisition latency (ops are shared by all threads).
+//-----------------------------------------------------------------------------------------
+void contended(int threads, int cs, int ops)
+{
+	std::vector<Worker> workers(threads);
+	pthread_barrier_init(&barrier, NULL, threads);
+	for (int i = 0; i < threads; i++)
+	{
+		workers[i].id = i + 1;
+		workers[i].ops = ops / threads;
+		workers[i].cs = cs;
+		workers[i].latency = new LatencyRecorder(workers[i].ops);
+		pthread_create(&workers[i].thread, NULL, contend, &workers[i]);
+	}
+
+	LatencyRecorder latency(ops);
+	for (int i = 0; i < threads; i++)
+		pthread_join(workers[i].thread, NULL);
+	long long elapsed = nowNs() - contendedStart;
+
+	for (int i = 0; i < threads; i++)
+	{
+		latency.merge(*workers[i].latency);
+		delete workers[i].latency;
+	}
+	pthread_barrier_destroy(&barrier);
+
+	report("contended", threads, cs, elapsed, latency);
+}
+
+//-----------------------------------------------------------------------------------------
+// Handoff benchmark state
+//-----------------------------------------------------------------------------------------
+std::atomic<int> handoffRound;			// round the owner has locked
+std::atomic<int> handoffDone;			// round the waiter has completed
+std::atomic<long long> handoffReleased;	// unlock time of the current round
+LatencyRecorder* handoffLatency = NULL;
+
+//-----------------------------------------------------------------------------------------
+// Waiter: blocks on the mutex locked by the owner, measures the handoff.
+//-----------------------------------------------------------------------------------------
+void* handoffWaiter(void* arg)
+{
+	int rounds = (int) (long) arg;
+	for (int round = 1; round <= rounds; round++)
+	{
+		while (handoffRound.load() != round)
+			sched_yield();
+
+		lockAt(0, 2);
+		handoffLatency->add(nowNs() - handoffReleased.load());
+		unlockAt(0, 2);
+		handoffDone.store(round);
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------------------
+// Unlock to wakeup latency of a blocked waiter.
+//-----------------------------------------------------------------------------------------
+void handoff(int rounds)
+{
+	handoffRound.store(0);
+	handoffDone.store(0);
+	handoffLatency = new LatencyRecorder(rounds);
+
+	pthread_t waiter;
+	pthread_create(&waiter, NULL, handoffWaiter, (void*) (long) rounds);
+
+	long long start = nowNs();
+	for (int round = 1; round <= rounds; round++)
+	{
+		lockAt(0, 1);
+		handoffRound.store(round);
+		usleep(HANDOFF_SLEEP_US);
+		handoffReleased.store(nowNs());
+		unlockAt(0, 1);
+
+		while (handoffDone.load() != round)
+			sched_yield();
+	}
+	long long elapsed = nowNs() - start;
+	pthread_join(waiter, NULL);
+
+	report("handoff", 2, 0, elapsed, *handoffLatency);
+	delete handoffLatency;
+}
+
+//-----------------------------------------------------------------------------------------
+// Parses comma separated list of integers (each at least minimum).
+//-----------------------------------------------------------------------------------------
+bool parseList(const char* text, std::vector<int>& values, int minimum)
+{
+	values.clear();
+	const char *token = text;
+	while (*token != '\0')
+	{
+		char *end;
+		long value = strtol(token, &end, 10);
+		if (end == token || value < minimum || (*end != ',' && *end != '\0'))
+			return false;
+
+		values.push_back(value);
+		token = (*end == ',') ? end + 1 : end;
+	}
+
+	return !values.empty();
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	std::vector<int> threadCounts, csLengths, mutexCounts;
+	parseList("1,2,4,16,64", threadCounts, 1);
+	parseList("0,1000", csLengths, 0);
+	parseList("1,16,10000", mutexCounts, 1);
+	int ops = 100000;
+	int rounds = 1000;
+	const char* path = "lockbench.csv";
+
+	int option;
+	bool usage = false;
+	while ((option = getopt(argc, argv, "t:c:m:n:r:o:")) != -1)
+	{
+		switch (option)
+		{
+			case 't': usage |= !parseList(optarg, threadCounts, 1); break;
+			case 'c': usage |= !parseList(optarg, csLengths, 0); break;
+			case 'm': usage |= !parseList(optarg, mutexCounts, 1); break;
+			case 'n': ops = atoi(optarg); usage |= (ops <= 0); break;
+			case 'r': rounds = atoi(optarg); usage |= (rounds <= 0); break;
+			case 'o': path = optarg; break;
+			default: usage = true; break;
+		}
+	}
+
+	if (usage || optind != argc)
+	{
+		fprintf(stderr, "usage: %s [-t threads,...] [-c cs_ns,...] [-m mutexes,...] [-n ops] [-r rounds]"
+				" [-o file.csv]\n", argv[0]);
+		return 1;
+	}
+
+	csv = fopen(path, "w");
+	if (csv == NULL)
+	{
+		perror(path);
+		return 1;
+	}
+	fprintf(csv, "benchmark,mutex,threads,cs_ns,mutexes,samples,mops,mean_ns,p50_ns,p99_ns,p999_ns\n");
+
+	// emulated mutexes look up task priorities in the queue
+	queue.insert(1, CEILING);
+	queue.insert(2, CEILING);
+
+	printf("%-12s %-10s %7s %7s %7s %9s %9s %9s %9s\n", "benchmark", "mutex", "threads", "cs_ns",
+			"mutexes", "Mop/s", "p50_ns", "p99_ns", "p99.9_ns");
+
+	for (int type = 0; type < LOCK_TYPES; type++)
+	{
+		for (size_t m = 0; m < mutexCounts.size(); m++)
+		{
+			createLocks(type, mutexCounts[m]);
+			uncontended(ops);
+			destroyLocks();
+		}
+	}
+
+	for (int type = 0; type < LOCK_TYPES; type++)
+	{
+		if (!lockBlocks[type])
+			continue;
+
+		for (size_t m = 0; m < mutexCounts.size(); m++)
+		{
+			createLocks(type, mutexCounts[m]);
+			for (size_t t = 0; t < threadCounts.size(); t++)
+			{
+				for (size_t c = 0; c < csLengths.size(); c++)
+					contended(threadCounts[t], csLengths[c], ops);
+			}
+			destroyLocks();
+		}
+	}
+
+	for (int type = 0; type < LOCK_TYPES; type++)
+	{
+		if (!lockBlocks[type])
+			continue;
+
+		createLocks(type, 1);
+		handoff(rounds);
+		destroyLocks();
+	}
+
+	fclose(csv);
+	printf("results written to %s\n", path);
+	return 0;
+}
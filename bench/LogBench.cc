@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "../Mutex.h"
+#include "../PiMutex.h"
+#include "../PcMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// Logging overhead benchmark.
+// Build twice and compare the per-operation latency (results go to stderr):
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 LogBench.cc ../Trace.cc ../Profile.cc -lpthread   (quiet)
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=3 LogBench.cc ../Trace.cc ../Profile.cc -lpthread   (debug)
+// and run with stdout redirected: ./a.out > /dev/null
+//
+// usage: LogBench [iterations]
+//=============================================================================
+
+//-----------------------------------------------------------------------------------------
+// Prints average latency of one operation.
+//-----------------------------------------------------------------------------------------
+void report(const char* name, long long start, int iterations)
+{
+	fprintf(stderr, "%-28s %10.1f ns/op\n", name, (double) (nowNs() - start) / iterations);
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int iterations = (argc > 1) ? atoi(argv[1]) : 100000;
+	fprintf(stderr, "LOG_LEVEL=%d, %d iterations\n", LOG_LEVEL, iterations);
+
+	long long start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		Mutex* mutex = new Mutex();
+		delete mutex;
+	}
+	report("Mutex create/destroy", start, iterations);
+
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		PiMutex* piMutex = new PiMutex();
+		delete piMutex;
+	}
+	report("PiMutex create/destroy", start, iterations);
+
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		PcMutex* pcMutex = new PcMutex();
+		delete pcMutex;
+	}
+	report("PcMutex create/destroy", start, iterations);
+
+	Mutex mutex;
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		mutex.lock();
+		mutex.unlock();
+	}
+	report("Mutex lock/unlock", start, iterations);
+
+	ReadyQueue queue(2);
+	queue.insert(1, 50);
+
+	PiMutex piMutex;
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		piMutex.lock(1, &queue);
+		piMutex.unlock(1, &queue);
+	}
+	report("PiMutex lock/unlock", start, iterations);
+
+	PcMutex pcMutex[1];
+	pcMutex[0].setId(1);
+	pcMutex[0].setCsPriority(50);
+	start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		pcMutex[0].lock(1, &queue);
+		pcMutex[0].unlock(&queue);
+	}
+	report("PcMutex lock/unlock", start, iterations);
+
+	return 0;
+}
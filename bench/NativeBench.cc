@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "Bench.h"
+#include "../PiMutex.h"
+#include "../PcMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// Emulated against native (kernel enforced) protocol benchmark.
+//  1. uncontended lock/unlock latency of PiMutex and PcMutex in both modes;
+//  2. priority inversion duration: on one CPU with SCHED_FIFO threads, a low priority
+//     thread holds the mutex, a high priority thread needs it and a medium priority
+//     thread computes in between. Reports how long the high priority thread waits.
+// The emulated protocols only change the ReadyQueue, which the kernel never sees, so the
+// medium thread runs ahead of the owner. The native ones boost the owner in the kernel.
+// Part 2 needs SCHED_FIFO (root or CAP_SYS_NICE).
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 NativeBench.cc ../Trace.cc ../Profile.cc -lpthread
+//
+// usage: NativeBench [rounds]
+//=============================================================================
+
+#define TASK_LOW 1
+#define TASK_MEDIUM 2
+#define TASK_HIGH 3
+
+#define PRIORITY_LOW 10
+#define PRIORITY_MEDIUM 60
+#define PRIORITY_HIGH 70
+#define PRIORITY_MAIN 90
+
+#define CS_NS 2000000LL			// low priority critical section (CPU time)
+#define MEDIUM_NS 20000000LL	// medium priority computation (CPU time)
+#define RETRY_US 50				// emulated lock retry interval
+
+ReadyQueue queue(4);
+pthread_mutex_t guard = PTHREAD_MUTEX_INITIALIZER;	// serializes emulated mutex calls (CPU mutex)
+PiMutex* piMutex = NULL;
+PcMutex* pcMutex = NULL;
+long long waitNs = 0;		// high priority thread wait time (last round)
+
+//-----------------------------------------------------------------------------------------
+// Returns calling thread CPU time in nanoseconds.
+//-----------------------------------------------------------------------------------------
+long long cpuNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------------------
+// Computes for duration nanoseconds of CPU time.
+//-----------------------------------------------------------------------------------------
+void compute(long long duration)
+{
+	long long end = cpuNs() + duration;
+	while (cpuNs() < end)
+		;
+}
+
+//-----------------------------------------------------------------------------------------
+// Locks the mutex under test. Emulated locks do not block, so they are retried.
+//-----------------------------------------------------------------------------------------
+void lockMutex(int task)
+{
+	while (1)
+	{
+		bool native = (piMutex != NULL) ? piMutex->isNative() : pcMutex->isNative();
+		if (!native)
+			pthread_mutex_lock(&guard);
+
+		int status = (piMutex != NULL) ? piMutex->lock(task, &queue) : pcMutex->lock(task, &queue);
+
+		if (!native)
+			pthread_mutex_unlock(&guard);
+		if (status == 0)
+			return;
+
+		usleep(RETRY_US);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Unlocks the mutex under test.
+//-----------------------------------------------------------------------------------------
+void unlockMutex(int task)
+{
+	bool native = (piMutex != NULL) ? piMutex->isNative() : pcMutex->isNative();
+	if (!native)
+		pthread_mutex_lock(&guard);
+
+	if (piMutex != NULL)
+		piMutex->unlock(task, &queue);
+	else
+		pcMutex->unlock(&queue);
+
+	if (!native)
+		pthread_mutex_unlock(&guard);
+}
+
+//-----------------------------------------------------------------------------------------
+// Task threads
+//-----------------------------------------------------------------------------------------
+void* low(void*)
+{
+	lockMutex(TASK_LOW);
+	compute(CS_NS);
+	unlockMutex(TASK_LOW);
+	return NULL;
+}
+
+void* medium(void*)
+{
+	compute(MEDIUM_NS);
+	return NULL;
+}
+
+void* high(void*)
+{
+	long long start = nowNs();
+	lockMutex(TASK_HIGH);
+	waitNs = nowNs() - start;
+	unlockMutex(TASK_HIGH);
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------------------
+// Creates SCHED_FIFO thread with the given priority level.
+//-----------------------------------------------------------------------------------------
+int createThread(pthread_t* thread, void* (*function)(void*), int priority)
+{
+	pthread_attr_t attributes;
+	struct sched_param param;
+	param.sched_priority = nativePriority(priority);
+
+	pthread_attr_init(&attributes);
+	pthread_attr_setinheritsched(&attributes, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attributes, SCHED_FIFO);
+	pthread_attr_setschedparam(&attributes, &param);
+	int status = pthread_create(thread, &attributes, function, NULL);
+	pthread_attr_destroy(&attributes);
+
+	return status;
+}
+
+//-----------------------------------------------------------------------------------------
+// Runs the inversion scenario, returns high priority wait time (ns) or -1 (failure).
+//-----------------------------------------------------------------------------------------
+long long inversion()
+{
+	queue.insert(TASK_LOW, PRIORITY_LOW);
+	queue.insert(TASK_MEDIUM, PRIORITY_MEDIUM);
+	queue.insert(TASK_HIGH, PRIORITY_HIGH);
+
+	// low locks the mutex first, then medium and high are released together
+	pthread_t threads[3];
+	if (createThread(&threads[0], low, PRIORITY_LOW) != 0)
+		return -1;
+	usleep(200);
+	if (createThread(&threads[1], medium, PRIORITY_MEDIUM) != 0
+			|| createThread(&threads[2], high, PRIORITY_HIGH) != 0)
+		return -1;
+
+	for (int i = 0; i < 3; i++)
+		pthread_join(threads[i], NULL);
+
+	queue.remove(TASK_LOW);
+	queue.remove(TASK_MEDIUM);
+	queue.remove(TASK_HIGH);
+	return waitNs;
+}
+
+//-----------------------------------------------------------------------------------------
+// Measures uncontended lock/unlock latency of the mutex under test.
+//-----------------------------------------------------------------------------------------
+void latency(const char* name, int iterations)
+{
+	queue.insert(TASK_LOW, PRIORITY_LOW);
+	LatencyRecorder recorder(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		long long start = nowNs();
+		if (piMutex != NULL)
+		{
+			piMutex->lock(TASK_LOW, &queue);
+			piMutex->unlock(TASK_LOW, &queue);
+		}
+		else
+		{
+			pcMutex->lock(TASK_LOW, &queue);
+			pcMutex->unlock(&queue);
+		}
+		recorder.add(nowNs() - start);
+	}
+	queue.remove(TASK_LOW);
+
+	printf("%-24s %8lld ns p50 %8lld ns p99\n", name, recorder.percentile(50), recorder.percentile(99));
+}
+
+//-----------------------------------------------------------------------------------------
+// Selects the mutex under test (protocol 'i' or 'c', native or emulated).
+//-----------------------------------------------------------------------------------------
+void selectMutex(char protocol, bool native)
+{
+	delete piMutex;
+	delete pcMutex;
+	piMutex = NULL;
+	pcMutex = NULL;
+
+	if (protocol == 'i')
+	{
+		piMutex = new PiMutex();
+		piMutex->setNative(native);
+	}
+	else
+	{
+		pcMutex = new PcMutex();
+		pcMutex->setCsPriority(PRIORITY_HIGH);
+		pcMutex->setNative(native);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int rounds = (argc > 1) ? atoi(argv[1]) : 10;
+	const char* names[4] = { "PiMutex emulated", "PiMutex native", "PcMutex emulated", "PcMutex native" };
+
+	printf("lock/unlock latency (uncontended)\n");
+	for (int i = 0; i < 4; i++)
+	{
+		selectMutex((i < 2) ? 'i' : 'c', (i % 2) == 1);
+		latency(names[i], 100000);
+	}
+
+	// all threads on one CPU, orchestrated from above the task priorities
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(0, &cpus);
+	struct sched_param param;
+	param.sched_priority = nativePriority(PRIORITY_MAIN);
+	if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0
+			|| pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+	{
+		printf("inversion duration: skipped (SCHED_FIFO not permitted)\n");
+		return 0;
+	}
+
+	printf("inversion duration (cs %lld us, medium %lld us, %d rounds)\n", CS_NS / 1000, MEDIUM_NS / 1000, rounds);
+	for (int i = 0; i < 4; i++)
+	{
+		selectMutex((i < 2) ? 'i' : 'c', (i % 2) == 1);
+		LatencyRecorder recorder(rounds);
+		for (int j = 0; j < rounds; j++)
+		{
+			long long wait = inversion();
+			if (wait < 0)
+			{
+				printf("%-24s failed to create threads\n", names[i]);
+				return 1;
+			}
+			recorder.add(wait);
+		}
+		printf("%-24s %8.0f us mean %8lld us max\n", names[i], recorder.mean() / 1000,
+				recorder.percentile(100) / 1000);
+	}
+
+	delete piMutex;
+	delete pcMutex;
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "Bench.h"
+#include "../WorkerPool.h"
+
+//=============================================================================
+// Job release latency benchmark.
+// Time from the release (pthread_create, or WorkerPool::run) to the first instruction
+// of the job, one job at a time. The scheduler released every job with pthread_create
+// before the worker pool.
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 PoolBench.cc ../WorkerPool.cc -lpthread
+//
+// usage: PoolBench [iterations] [cpu]
+//=============================================================================
+
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t finished = PTHREAD_COND_INITIALIZER;
+bool jobDone;
+long long releaseTime;
+LatencyRecorder* latency;
+
+//-----------------------------------------------------------------------------------------
+// Job: records its start latency and signals completion.
+//-----------------------------------------------------------------------------------------
+void* job(void*)
+{
+	long long start = nowNs();
+
+	pthread_mutex_lock(&mutex);
+	latency->add(start - releaseTime);
+	jobDone = true;
+	pthread_cond_signal(&finished);
+	pthread_mutex_unlock(&mutex);
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------------------
+// Waits for the released job to finish.
+//-----------------------------------------------------------------------------------------
+void waitForJob()
+{
+	pthread_mutex_lock(&mutex);
+	while (!jobDone)
+		pthread_cond_wait(&finished, &mutex);
+	jobDone = false;
+	pthread_mutex_unlock(&mutex);
+}
+
+//-----------------------------------------------------------------------------------------
+// Prints latency percentiles.
+//-----------------------------------------------------------------------------------------
+void report(const char* name)
+{
+	printf("%-16s %9lld ns %9lld ns %9lld ns\n", name, latency->percentile(50),
+			latency->percentile(99), latency->percentile(100));
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int iterations = (argc > 1) ? atoi(argv[1]) : 10000;
+	int cpu = (argc > 2) ? atoi(argv[2]) : NO_CPU;
+	if (iterations < 1)
+	{
+		fprintf(stderr, "usage: PoolBench [iterations > 0] [cpu]\n");
+		return 1;
+	}
+
+	pthread_attr_t detached;
+	pthread_attr_init(&detached);
+	pthread_attr_setdetachstate(&detached, PTHREAD_CREATE_DETACHED);
+
+	if (cpu != NO_CPU && WorkerPool::pin(cpu) != 0)
+		fprintf(stderr, "cannot pin to CPU %d\n", cpu);
+
+	printf("%d releases\n", iterations);
+	printf("%-16s %12s %12s %12s\n", "release", "start p50", "start p99", "start max");
+
+	latency = new LatencyRecorder(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		pthread_t thread;
+		releaseTime = nowNs();
+		pthread_create(&thread, &detached, job, NULL);
+		waitForJob();
+	}
+	report("pthread_create");
+	delete latency;
+
+	// the previous worker may not be idle yet when the next job is released
+	WorkerPool pool(2, cpu);
+	latency = new LatencyRecorder(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		releaseTime = nowNs();
+		pool.run(job, NULL);
+		waitForJob();
+	}
+	report("worker pool");
+	printf("(%d workers)\n", pool.getSize());
+	delete latency;
+
+	return 0;
+}
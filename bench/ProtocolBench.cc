@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Bench.h"
+#include "../ProtocolMutex.h"
+#include "../ReadyQueue.h"
+
+//=============================================================================
+// Protocol overhead benchmark.
+// One task locks and unlocks one mutex of every ProtocolMutex instantiation
+// (uncontended, emulated protocols). The protocol is a template parameter, so each
+// loop is compiled against one policy with lock and unlock inlined.
+//   g++ -O2 -std=c++17 -DLOG_LEVEL=0 ProtocolBench.cc ../Trace.cc ../Profile.cc -lpthread
+//
+// usage: ProtocolBench [iterations]
+//=============================================================================
+
+//-----------------------------------------------------------------------------------------
+// Measures lock + unlock of a ProtocolMutex<Policy> and prints one line.
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+void run(const char* name, int iterations)
+{
+	ReadyQueue queue(2);
+	queue.insert(1, 50);
+
+	ProtocolMutex<Policy> mutex;
+	mutex.setId(1);
+	mutex.setCsPriority(60);
+
+	LatencyRecorder latency(iterations);
+	long long total = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		long long start = nowNs();
+		mutex.lock(1, &queue);
+		mutex.unlock(1, &queue);
+		latency.add(nowNs() - start);
+	}
+	double mean = (double) (nowNs() - total) / iterations;
+
+	printf("%-20s %9lld ns %9lld ns %9.1f ns\n", name, latency.percentile(50),
+			latency.percentile(99), mean);
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int iterations = (argc > 1) ? atoi(argv[1]) : 1000000;
+	if (iterations < 1)
+	{
+		fprintf(stderr, "usage: ProtocolBench [iterations > 0]\n");
+		return 1;
+	}
+
+	printf("%d iterations (lock + unlock)\n", iterations);
+	printf("%-20s %12s %12s %12s\n", "protocol", "p50", "p99", "mean");
+
+	run<NoProtocol>("none", iterations);
+	run<InheritancePolicy>("inheritance", iterations);
+	run<CeilingPolicy>("ceiling", iterations);
+	run<ImmediateCeilingPolicy>("immediate ceiling", iterations);
+	run<SrpPolicy>("srp", iterations);
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <queue>
+#include <vector>
+
+#include "Bench.h"
+#include "../TimingWheel.h"
+
+//=============================================================================
+// Release queue benchmark.
+// [tasks] periodic release events with periods spread log-uniformly from 1 us to 10 min
+// (time unit: microseconds). Each iteration expires the earliest release and schedules
+// the next one of the same task (the scheduler's steady state). Compares the timing
+// wheel with the binary heap (std::priority_queue) it replaces.
+//   g++ -O2 -std=c++17 WheelBench.cc ../TimingWheel.cc
+//
+// usage: WheelBench [tasks] [iterations]
+//=============================================================================
+
+#define MIN_PERIOD 1ULL					// 1 us
+#define MAX_PERIOD 600000000ULL			// 10 min
+
+//-----------------------------------------------------------------------------------------
+// Returns periods of all tasks (fixed seed, same for both queues).
+//-----------------------------------------------------------------------------------------
+std::vector<uint64_t> makePeriods(int tasks)
+{
+	std::vector<uint64_t> periods(tasks);
+	srand(1);
+	for (int i = 0; i < tasks; i++)
+	{
+		double exponent = (double) rand() / RAND_MAX * log((double) MAX_PERIOD / MIN_PERIOD);
+		periods[i] = (uint64_t) (MIN_PERIOD * exp(exponent));
+	}
+
+	return periods;
+}
+
+//-----------------------------------------------------------------------------------------
+// Heap: returns mean ns per release, sum of release times in *check.
+//-----------------------------------------------------------------------------------------
+double runHeap(std::vector<uint64_t>& periods, int iterations, uint64_t* check)
+{
+	std::priority_queue<std::pair<uint64_t, int>, std::vector<std::pair<uint64_t, int> >,
+			std::greater<std::pair<uint64_t, int> > > releases;
+	for (size_t i = 0; i < periods.size(); i++)
+		releases.push(std::make_pair(periods[i], (int) i));
+
+	*check = 0;
+	long long start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		std::pair<uint64_t, int> release = releases.top();
+		releases.pop();
+		*check += release.first;
+		releases.push(std::make_pair(release.first + periods[release.second], release.second));
+	}
+
+	return (double) (nowNs() - start) / iterations;
+}
+
+//-----------------------------------------------------------------------------------------
+// Timing wheel: returns mean ns per release, sum of release times in *check.
+//-----------------------------------------------------------------------------------------
+double runWheel(std::vector<uint64_t>& periods, int iterations, uint64_t* check)
+{
+	TimingWheel wheel;
+	std::vector<TimerEvent> events(periods.size());
+	for (size_t i = 0; i < periods.size(); i++)
+	{
+		TimingWheel::init(&events[i], 0, (int) i);
+		wheel.schedule(&events[i], periods[i]);
+	}
+
+	*check = 0;
+	long long start = nowNs();
+	for (int i = 0; i < iterations; i++)
+	{
+		TimerEvent *event = wheel.expire(wheel.nextExpiry());
+		*check += event->expiry;
+		wheel.schedule(event, event->expiry + periods[event->data]);
+	}
+
+	return (double) (nowNs() - start) / iterations;
+}
+
+//-----------------------------------------------------------------------------------------
+// Main function
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int maxTasks = (argc > 1) ? atoi(argv[1]) : 1000000;
+	int iterations = (argc > 2) ? atoi(argv[2]) : 1000000;
+	if (maxTasks < 1 || iterations < 1)
+	{
+		fprintf(stderr, "usage: WheelBench [tasks > 0] [iterations > 0]\n");
+		return 1;
+	}
+
+	printf("periods %llu us .. %llu us, %d iterations\n", MIN_PERIOD, MAX_PERIOD, iterations);
+	printf("%8s %12s %12s\n", "tasks", "heap", "wheel");
+
+	for (int tasks = 10; tasks <= maxTasks; tasks *= 10)
+	{
+		std::vector<uint64_t> periods = makePeriods(tasks);
+
+		uint64_t heapCheck, wheelCheck;
+		double heap = runHeap(periods, iterations, &heapCheck);
+		double wheel = runWheel(periods, iterations, &wheelCheck);
+		if (heapCheck != wheelCheck)
+		{
+			fprintf(stderr, "release times differ (%d tasks)\n", tasks);
+			return 1;
+		}
+
+		printf("%8d %9.1f ns %9.1f ns\n", tasks, heap, wheel);
+	}
+
+	return 0;
+}
@@ -1,134 +1,244 @@
 #include <stdio.h>
-#include <iostream.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <errno.h>
 #include <unistd.h>
 #include <pthread.h>
+
+#ifdef __QNX__
+#include <iostream.h>
 #include <sync.h>
 #include <sys/siginfo.h>
 #include <sys/neutrino.h>
 #include <sys/netmgr.h>
 #include <sys/syspage.h>
+#else
+#include <iostream>
+#endif
 
+#include <vector>
+
+#include "Accounting.h"
+#include "CoJob.h"
+#include "Deadlock.h"
 #include "PulseTimer.h"
-#include "PiMutex.h"
-#include "PcMutex.h"
+#include "ProtocolMutex.h"
+#include "Profile.h"
+#include "ReadyQueue.h"
+#include "TaskSet.h"
+#include "TimingWheel.h"
+#include "Trace.h"
+#include "WorkerPool.h"
 //=============================================================================
 
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+pthread_cond_t done = PTHREAD_COND_INITIALIZER;	// signalled when a thread parks (virtual time)
+WorkerPool* workers;							// job threads, reused across releases
+
+
+// workers started ahead of time (default: one per task, at most)
+#define DEFAULT_WORKERS 64
 
-#define threadCount 10	/* Maximum number of threads*/
-#define mtxCount 1		// number of mutexes
-#define eps .005		// priority increment
+// step results
+#define STEP_COMPUTED 0	// executed one compute tick
+#define STEP_BLOCKED 1	// lock not acquired, retried on next dispatch
+#define STEP_NONE 2		// script ended without computing
+#define STEP_PREEMPTED 3	// tickless: a higher priority thread became ready, retried on next dispatch
 
-#define RELEASE_TIME_P1 4
-#define RELEASE_TIME_P2 2
-#define RELEASE_TIME_P3 0
+// deadlock detection modes (-d)
+#define DEADLOCK_OFF 0		// no detection
+#define DEADLOCK_RECORD 1	// report cycles, keep running
+#define DEADLOCK_ABORT 2	// report the first cycle and terminate
 
-#define PRIORITY_P1	0.7
-#define PRIORITY_P2	0.6
-#define PRIORITY_P3	0.5
+// timer event types
+#define EVENT_RELEASE 1		// release next job of task
+#define EVENT_DEADLINE 2	// deadline of the current job of task (implicit, one period)
 
-float priority[threadCount] = {0};	// priority of threads
+TaskSet taskSet;					// loaded task set (tasks, scripts, resources)
+ReadyQueue* readyQueue;				// priorities and states of released threads
+pthread_cond_t* taskCond;			// per-thread wait slot, signalled only when dispatched
+bool* parked;						// thread is waiting for the manager (or terminated)
+bool* jobActive;					// task has a released, not yet completed job
 int active_p = 0;					// detemine the active thread that should be run
+int dispatched_p = 0;				// thread dispatched in the current tick (0 if idle)
+bool virtualTime = false;			// advance time on events instead of timer pulses
+bool tickless = false;				// dispatch up to the next event instead of one tick
+int slice = 1;						// ticks the dispatched thread may compute
+int executed = 0;					// ticks computed by the last step
+struct timespec startTime;			// real time of tick 0 (tickless)
+bool coroutines = false;			// run jobs as coroutines on the scheduler thread
+int currentTick = 0;				// scheduler time of the current tick
+Accounting* accounting;				// per-task response and blocking times
+
+// pending releases and deadlines (data = task index), one timer event of each kind per task
+TimingWheel wheel;
+TimerEvent* releaseEvents;
+TimerEvent* deadlineEvents;
 
-void ThreadManager();
+//-----------------------------------------------------------------------------------------
+// Resource mutexes (one per resource) of the protocol selected with -p. The job code is
+// instantiated per protocol (Policy), main selects the instantiation once.
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+ProtocolMutex<Policy>* protocolMutex;
 
 //-----------------------------------------------------------------------------------------
-// Instantiates "Priority Inheritance" and "Priority Ceiling" mutexes.
+// Marks thread as parked (back at its wait point) and notifies the virtual time scheduler.
+// Must be called with the CPU mutex held.
 //-----------------------------------------------------------------------------------------
-PiMutex piMutex;
-PcMutex pcMutex[mtxCount];
+void parkThread(int threadId)
+{
+	parked[threadId] = true;
+	pthread_cond_signal(&done);
+}
 
 //-----------------------------------------------------------------------------------------
-// Thread 1 (highest priority)
+// Locks resource with protocol Policy. Returns 0 if the resource was acquired.
 //-----------------------------------------------------------------------------------------
-void * P1(void* arg)
+template <typename Policy>
+int lockWith(int threadId, int resource)
 {
-	int cnt = 0;
-	while(1)
-	{
-		printf("\nP1: lock CPU mutex");
-		pthread_mutex_lock(&mutex);
+	return protocolMutex<Policy>[resource - 1].lock(threadId, readyQueue);
+}
 
-		// wait for the message from ThreadManager and check if current thread is active
-		printf("\nP1: suspended, priority: %.2f", priority[1]);
-		while (active_p != 1)
-			pthread_cond_wait(&cond, &mutex);
+//-----------------------------------------------------------------------------------------
+// Unlocks resource with protocol Policy.
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+int unlockWith(int threadId, int resource)
+{
+	return protocolMutex<Policy>[resource - 1].unlock(threadId, readyQueue);
+}
 
-		printf("\nP1: resumed, executing, cnt: %d", cnt);
-		active_p = 0;
+//-----------------------------------------------------------------------------------------
+// Creates one mutex of protocol Policy per resource (CS priorities are the computed
+// ceilings, immediate ceiling where declared).
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+void createMutexes()
+{
+	int mtxCount = taskSet.getResourceCount();
+	protocolMutex<Policy> = new ProtocolMutex<Policy>[mtxCount];
+	for (int i = 0; i < mtxCount; i++)
+	{
+		protocolMutex<Policy>[i].setCsPriority(taskSet.getResource(i + 1)->ceiling);
+		protocolMutex<Policy>[i].setImmediate(taskSet.getResource(i + 1)->immediate);
+		protocolMutex<Policy>[i].setId(i + 1);
+	}
+}
 
-		if (cnt == 1)
+//-----------------------------------------------------------------------------------------
+// Executes task script from the current segment: lock/unlock segments up to and including
+// the compute segment, of which it computes up to slice ticks (sets executed). Stops at a
+// lock that was not acquired (retried on next dispatch).
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+int step(TaskSpec* task, int* segment, int* remaining)
+{
+	int last = task->firstSegment + task->segmentCount;
+	while (*segment < last)
+	{
+		TaskSegment* current = taskSet.getSegment(*segment);
+		if (current->type == SEGMENT_LOCK)
 		{
-			// Try to acquire mutex after running for 1 unit
-			printf("\nP1: try CS lock");
-//			piMutex.lock(&priority[1]);		// use PI mutex
-			pcMutex[0].lock(1, priority, pcMutex, mtxCount);		// use PC mutex
+			Trace::record(TRACE_TASK_TRY_LOCK, task->id, current->value, 0, 0);
+			if (lockWith<Policy>(task->id, current->value) != 0)
+			{
+				Trace::record(TRACE_TASK_BLOCKED, task->id, current->value, 0, 0);
+				return STEP_BLOCKED;
+			}
+			(*segment)++;
 		}
-		else if (cnt == 2)
+		else if (current->type == SEGMENT_UNLOCK)
 		{
-			// Release mutex after running for 3 units
-			printf("\nP1: try CS unlock");
-//			piMutex.unlock(&priority[1]);		// use PI mutex
-			pcMutex[0].unlock();		// use PC mutex
+			Trace::record(TRACE_TASK_TRY_UNLOCK, task->id, current->value, 0, 0);
+			unlockWith<Policy>(task->id, current->value);
+			(*segment)++;
 		}
-		else if (cnt == 3)
+		else
 		{
-			// Terminate after 4 units
-			printf("\nP1: thread execution completed");
+			// without ticks, a lock/unlock that readied a higher priority thread preempts at once
+			if (tickless && readyQueue->getPriority(readyQueue->top()) > readyQueue->getPriority(task->id))
+				return STEP_PREEMPTED;
+
+			if (*remaining == 0)
+				*remaining = current->value;
+			executed = (*remaining < slice) ? *remaining : slice;
+			*remaining -= executed;
+			if (*remaining == 0)
+				(*segment)++;
+			return STEP_COMPUTED;
+		}
+	}
 
-			// remove 1st process from the ThreadManager's queue
-			priority[1] = 0;
+	return STEP_NONE;
+}
 
-			printf("\nP1: unlock CPU mutex");
-			pthread_mutex_unlock(&mutex);
-			break;
-		}
-		printf("\nP1: executed, cnt: %d", cnt);
+//-----------------------------------------------------------------------------------------
+// Executes the dispatched step of a job, cnt is the job's dispatch count. Completes the
+// job at the end of its script and returns true. Must be called with the CPU mutex held.
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+bool runStep(TaskSpec* task, int* segment, int* remaining, int cnt)
+{
+	int id = task->id;
+	executed = 0;
 
-		printf("\nP1: unlock CPU mutex");
-		pthread_mutex_unlock(&mutex);
-		cnt++;
-	}
+	if (step<Policy>(task, segment, remaining) == STEP_COMPUTED)
+		Trace::record(TRACE_TASK_EXECUTED, id, 0, 0, cnt);
 
-	return NULL;
+	if (*segment < task->firstSegment + task->segmentCount)
+		return false;
+
+	Trace::record(TRACE_TASK_COMPLETED, id, 0, 0, 0);
+
+	// remove the job from the ThreadManager's queue
+	readyQueue->remove(id);
+	jobActive[id] = false;
+	accounting->completed(task, currentTick + (tickless ? executed : 1));
+	wheel.cancel(&deadlineEvents[id]);
+	return true;
 }
 
 //-----------------------------------------------------------------------------------------
-// Thread 2 (medium priority)
+// Job thread: executes one step of the task's script each time it is dispatched.
 //-----------------------------------------------------------------------------------------
-void * P2(void* arg)
+template <typename Policy>
+void * runJob(void* arg)
 {
+	TaskSpec* task = (TaskSpec*) arg;
+	int id = task->id;
+	int segment = task->firstSegment;
+	int remaining = 0;
+
 	int cnt = 0;
 	while(1)
 	{
-		printf("\nP2: lock CPU mutex");
+		Trace::record(TRACE_TASK_LOCK_CPU, id, 0, 0, 0);
 		pthread_mutex_lock(&mutex);
 
 		// wait for the message from ThreadManager and check if current thread is active
-		printf("\nP2: suspended, priority: %.2f", priority[2]);
-		while (active_p != 2)
-			pthread_cond_wait(&cond, &mutex);
+		Trace::record(TRACE_TASK_SUSPENDED, id, 0, readyQueue->getPriority(id), 0);
+		while (active_p != id)
+		{
+			parkThread(id);
+			pthread_cond_wait(&taskCond[id], &mutex);
+		}
 
-		printf("\nP2: resumed, executing, cnt: %d", cnt);
+		Trace::record(TRACE_TASK_RESUMED, id, 0, 0, cnt);
 		active_p = 0;
 
-		if (cnt == 6)
+		if (runStep<Policy>(task, &segment, &remaining, cnt))
 		{
-			printf("\nP2: thread execution completed");
-
-			// remove 1st process from the ThreadManager's queue
-			priority[2] = 0;
+			parkThread(id);
 
-			printf("\nP2: unlock CPU mutex");
+			Trace::record(TRACE_TASK_UNLOCK_CPU, id, 0, 0, 0);
 			pthread_mutex_unlock(&mutex);
 			break;
 		}
-		printf("\nP2: executed, cnt: %d", cnt);
 
-		printf("\nP2: unlock CPU mutex");
+		Trace::record(TRACE_TASK_UNLOCK_CPU, id, 0, 0, 0);
 		pthread_mutex_unlock(&mutex);
 		cnt++;
 	}
@@ -136,144 +246,452 @@ void * P2(void* arg)
 	return NULL;
 }
 
+#ifdef COROUTINES_AVAILABLE
+std::coroutine_handle<>* coJobs;	// job coroutines (by task id)
+
 //-----------------------------------------------------------------------------------------
-// Thread 3 (lowest priority)
+// Job coroutine: same as the job thread, but resumed by the scheduler for every step.
 //-----------------------------------------------------------------------------------------
-void * P3(void* arg)
+template <typename Policy>
+CoJob coRunJob(TaskSpec* task)
 {
-	int cnt = 0;
-	while(1)
+	int segment = task->firstSegment;
+	int remaining = 0;
+
+	for (int cnt = 0; ; cnt++)
 	{
-		printf("\nP3: lock CPU mutex");
-		pthread_mutex_lock(&mutex);
+		Trace::record(TRACE_TASK_RESUMED, task->id, 0, 0, cnt);
+		active_p = 0;
 
-		// wait for the message from ThreadManager and check if current thread is active
-		printf("\nP3: suspended, priority: %.2f", priority[3]);
-		while (active_p != 3)
-			pthread_cond_wait(&cond, &mutex);
+		if (runStep<Policy>(task, &segment, &remaining, cnt))
+			co_return;
 
-		printf("\nP3: resumed, executing, cnt: %d", cnt);
-		active_p = 0;
+		// wait for the next dispatch
+		co_await std::suspend_always();
+	}
+}
 
-		if (cnt == 1)
+//-----------------------------------------------------------------------------------------
+// Runs one step of the dispatched job coroutine, frees it when the job completed.
+//-----------------------------------------------------------------------------------------
+void resumeJob(int threadId)
+{
+	coJobs[threadId].resume();
+	if (coJobs[threadId].done())
+	{
+		coJobs[threadId].destroy();
+		coJobs[threadId] = NULL;
+	}
+	parked[threadId] = true;
+}
+#endif
+
+//-----------------------------------------------------------------------------------------
+// Expires timer events due at time cnt: reports missed deadlines, releases jobs and
+// schedules the next release of periodic tasks. Must be called with the CPU mutex held.
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+void releaseJobs(int cnt)
+{
+	TimerEvent* event;
+	while ((event = wheel.expire(cnt)) != NULL)
+	{
+		TaskSpec* task = taskSet.getTask(event->data);
+
+		// deadlines are cancelled when the job completes
+		if (event->type == EVENT_DEADLINE)
 		{
-			printf("\nP3: try CS lock");
-//			piMutex.lock(&priority[3]);		// use PI mutex
-			pcMutex[0].lock(3, priority, pcMutex, mtxCount);		// use PC mutex
+			Trace::record(TRACE_DEADLINE_MISSED, task->id, 0, 0, 0);
+			continue;
 		}
-		else if (cnt == 3)
+
+		// the deadline is filed before the next release, so a miss is reported first
+		int release = (int) event->expiry;
+		if (task->period > 0)
 		{
-			printf("\nP3: try CS unlock");
-//			piMutex.unlock(&priority[3]);	// use PI mutex
-			pcMutex[0].unlock();	// use PC mutex
+			if (!jobActive[task->id])
+				wheel.schedule(&deadlineEvents[task->id], release + task->period);
+			wheel.schedule(event, release + task->period);
 		}
-		else if (cnt == 5)
+
+		// one job per task at a time
+		if (jobActive[task->id])
 		{
-			printf("\nP3: thread execution completed");
+			Trace::record(TRACE_JOB_OVERRUN, task->id, 0, 0, 0);
+			continue;
+		}
 
-			// remove 1st process from the ThreadManager's queue
-			priority[3] = 0;
+		jobActive[task->id] = true;
+		readyQueue->insert(task->id, task->priority);
+		accounting->released(task, cnt);
+		Trace::record(TRACE_RELEASE, task->id, 0, task->priority, 0);
 
-			printf("\nP3: unlock CPU mutex");
-			pthread_mutex_unlock(&mutex);
-			break;
-		}
-		printf("\nP3: executed, counter: %d", cnt);
+		// SRP blocks only here: the job waits for admission before it starts
+		ProtocolMutex<Policy>::released(task->id, task->priority, readyQueue);
 
-		printf("\nP3: unlock CPU mutex");
-		pthread_mutex_unlock(&mutex);
+#ifdef COROUTINES_AVAILABLE
+		if (coroutines)
+		{
+			coJobs[task->id] = coRunJob<Policy>(task).getHandle();
+			continue;
+		}
+#endif
 
-		cnt++;
+		workers->run(runJob<Policy>, task);
 	}
-
-	return NULL;
 }
 
-
 //-----------------------------------------------------------------------------------------
 // ThreadManager - determines which thread should run based on its current priority.
 //-----------------------------------------------------------------------------------------
 void threadManager()
 {
-	// find thread with the highest priority and flag it as active
-	float p =- 1;
-	for (int i = 1; i < threadCount; i++)
+	// take thread with the highest priority from the ready queue and flag it as active
+	active_p = readyQueue->top();
+	Trace::record(TRACE_ACTIVATE, active_p, 0, 0, 0);
+
+	// remember the dispatched thread, so virtual time can wait for its step to complete
+	dispatched_p = active_p;
+	parked[dispatched_p] = false;
+
+	// find higher priority jobs kept waiting by the dispatched thread
+	accounting->dispatched(dispatched_p, readyQueue);
+
+	// wake up only the selected thread (others keep sleeping on their own slots)
+	if (dispatched_p != 0)
 	{
-		if (priority[i] > p)
+		Trace::record(TRACE_NOTIFY, dispatched_p, 0, 0, 0);
+#ifdef COROUTINES_AVAILABLE
+		if (coroutines)
 		{
-			active_p = i;
-			p = priority[i];
+			resumeJob(dispatched_p);
+			return;
 		}
+#endif
+		pthread_cond_signal(&taskCond[dispatched_p]);
 	}
-	printf("\nThread manager: activate thread %d", active_p);
+}
 
-	printf("\nThread manager: notify threads");
-	pthread_cond_broadcast(&cond);
+//-----------------------------------------------------------------------------------------
+// Virtual time: blocks until the dispatched thread completed its step and parked again.
+// Replaces the timer pulse, so the tick lasts exactly as long as the work done in it.
+//-----------------------------------------------------------------------------------------
+void waitForDispatch()
+{
+	pthread_mutex_lock(&mutex);
+	while (dispatched_p != 0 && !parked[dispatched_p])
+		pthread_cond_wait(&done, &mutex);
+	pthread_mutex_unlock(&mutex);
 }
 
 //-----------------------------------------------------------------------------------------
-// Main function
+// Virtual time and tickless: returns the time of the next event (release, deadline or
+// termination) after cnt.
+//-----------------------------------------------------------------------------------------
+int nextEvent(int cnt)
+{
+	int next = taskSet.getEndTime();
+	uint64_t expiry = wheel.nextExpiry();
+	if (expiry > (uint64_t) cnt && expiry < (uint64_t) next)
+		next = (int) expiry;
+
+	return next;
+}
+
+//-----------------------------------------------------------------------------------------
+// Tickless: returns the ticks the last dispatch lasted. Idle lasts up to the next event,
+// a step that blocked or was preempted takes no time (the next thread is dispatched at
+// once), unless the same thread would be dispatched again to retry, which takes a tick
+// as in periodic mode.
+//-----------------------------------------------------------------------------------------
+int dispatchLength()
+{
+	pthread_mutex_lock(&mutex);
+	int ticks = executed;
+	if (dispatched_p == 0)
+		ticks = slice;
+	else if (ticks == 0 && readyQueue->top() == dispatched_p)
+		ticks = 1;
+	pthread_mutex_unlock(&mutex);
+
+	return ticks;
+}
+
+//-----------------------------------------------------------------------------------------
+// Tickless real time: arms the one-shot timer for tick time and waits for it.
 //-----------------------------------------------------------------------------------------
-int main(void)
+void waitForTick(PulseTimer* timer, int time)
 {
-	// initialize threads
-	pthread_t P1_ID, P2_ID, P3_ID;
+	long long offset = (long long) time * taskSet.getTimeUnit() * 1000LL;
+	struct timespec expiry;
+	expiry.tv_sec = startTime.tv_sec + offset / NANOSECONDS_PER_SECOND;
+	expiry.tv_nsec = startTime.tv_nsec + offset % NANOSECONDS_PER_SECOND;
+	if (expiry.tv_nsec >= NANOSECONDS_PER_SECOND)
+	{
+		expiry.tv_sec++;
+		expiry.tv_nsec -= NANOSECONDS_PER_SECOND;
+	}
 
-	// define CS priorities (based on static analysis)
-	pcMutex[0].setCsPriority(PRIORITY_P1);
-	pcMutex[0].setId(1);
+	timer->startAt(&expiry);
+	timer->wait();
+}
 
-	// create and start periodic timer to generate pulses every second.
-	PulseTimer* timer = new PulseTimer(1);
-	timer->start();
+//-----------------------------------------------------------------------------------------
+// Scheduler loop of protocol Policy: creates the resource mutexes, then releases and
+// dispatches jobs until the end time (or a detected deadlock in abort mode).
+//-----------------------------------------------------------------------------------------
+template <typename Policy>
+void schedule(PulseTimer* timer, int deadlockMode)
+{
+	// create one mutex per resource of the selected protocol
+	createMutexes<Policy>();
 
 	int cnt = 0;
+	int ticks = 0;		// length of the previous dispatch
 	while(1)
 	{
-		printf("\nScheduler: lock CPU mutex");
+		Trace::record(TRACE_SCHEDULER_LOCK, 0, 0, 0, 0);
 		pthread_mutex_lock(&mutex);
 
-		// release P1 t = 4
-		if(cnt == RELEASE_TIME_P1)
+		// charge the previous dispatch, release jobs due at t = cnt
+		accounting->elapsed(ticks);
+		currentTick = cnt;
+		releaseJobs<Policy>(cnt);
+
+		// terminate the program at the end time
+		if (cnt == taskSet.getEndTime())
 		{
-			priority[1] = PRIORITY_P1;	// 0.7
-			printf("\nP1 released");
-			pthread_create(&P1_ID, NULL, P1, NULL);
+			Trace::record(TRACE_TERMINATE, 0, 0, 0, cnt);
+			break;
 		}
-		// release P2 at t = 2
-		if(cnt == RELEASE_TIME_P2)
+
+		// or when the last dispatch closed a wait-for cycle
+		if (deadlockMode == DEADLOCK_ABORT && Deadlock::getCycles() > 0)
 		{
-			priority[2] = PRIORITY_P2;	// 0.6
-			printf("\nP2 released");
-			pthread_create(&P2_ID, NULL, P2, NULL);
+			Trace::record(TRACE_DEADLOCK_ABORT, 0, 0, 0, cnt);
+			break;
 		}
-		// release P3 at t = 0
-		if(cnt == RELEASE_TIME_P3)
+
+		// without ticks, the dispatched thread may compute up to the next event
+		slice = tickless ? nextEvent(cnt) - cnt : 1;
+		threadManager();
+
+		Trace::record(TRACE_SCHEDULER_UNLOCK, 0, 0, 0, 0);
+		pthread_mutex_unlock(&mutex);
+
+		ticks = 1;
+		if (tickless)
 		{
-			priority[3] = PRIORITY_P3;	// 0.5
-			printf("\nP3 released");
-			pthread_create(&P3_ID, NULL, P3, NULL);
+			// wait for the dispatched step, then (real time) for the time it computed
+			waitForDispatch();
+			ticks = dispatchLength();
+			if (ticks > 0)
+			{
+				if (!virtualTime)
+					waitForTick(timer, cnt + ticks);
+				Trace::record(TRACE_TICK, 0, 0, 0, cnt + ticks);
+			}
 		}
-		 // terminate the program at t = 30
-		if (cnt == 30)
+		else if (virtualTime)
 		{
-			printf("\n\n30 seconds are over, terminate program");
-			break;
+			// wait for the dispatched step, jump over idle ticks to the next event (an idle
+			// dispatch lasts until then)
+			waitForDispatch();
+			if (dispatched_p == 0)
+				ticks = nextEvent(cnt) - cnt;
+			Trace::record(TRACE_TICK, 0, 0, 0, cnt + ticks);
+		}
+		else
+		{
+			// wait for the timer pulse to fire
+			int missed = timer->wait();
+			Trace::record(TRACE_TICK, 0, 0, 0, cnt+1);
+			if (missed > 0)
+				Trace::record(TRACE_TICKS_MISSED, 0, 0, 0, missed);
 		}
 
-		threadManager();
+		cnt += ticks;
+	}
+}
 
-		printf("\nScheduler: unlock CPU mutex");
-		pthread_mutex_unlock(&mutex);
+//-----------------------------------------------------------------------------------------
+// Main function
+// Options: -v         run in virtual time (no timer, idle ticks are skipped)
+//          -n         tickless: dispatch up to the next event, one-shot timer per dispatch
+//          -c         run jobs as coroutines on the scheduler thread (C++20 builds)
+//          -w <n>     job threads started ahead of time (default: task count, at most 64)
+//          -a <cpu>   pin scheduler and job threads to cpu
+//          -t <file>  write binary trace to file (decode with tracedump) instead of stdout
+//          -p <p>     resource access protocol: none, pi, pc, ipc (immediate ceiling) or srp
+//                     (default pc)
+//          -s         print mutex statistics (acquisitions, contention, hold/wait times) at exit
+//          -d <mode>  detect deadlocks (wait-for cycles): record (report, keep running) or abort
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	const char* tracePath = NULL;
+	const char* taskSetPath = NULL;
+	bool statistics = false;
+	int deadlockMode = DEADLOCK_OFF;
+	bool usage = false;
+	void (*run)(PulseTimer* timer, int deadlockMode) = schedule<CeilingPolicy>;
+	int workerCount = -1;
+	int cpu = NO_CPU;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-v") == 0)
+			virtualTime = true;
+		else if (strcmp(argv[i], "-s") == 0)
+			statistics = true;
+		else if (strcmp(argv[i], "-n") == 0)
+			tickless = true;
+		else if (strcmp(argv[i], "-c") == 0)
+			coroutines = true;
+		else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+		{
+			i++;
+			if (strcmp(argv[i], "record") == 0)
+				deadlockMode = DEADLOCK_RECORD;
+			else if (strcmp(argv[i], "abort") == 0)
+				deadlockMode = DEADLOCK_ABORT;
+			else
+				usage = true;
+		}
+		else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			tracePath = argv[++i];
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+		{
+			workerCount = atoi(argv[++i]);
+			if (workerCount < 0)
+				usage = true;
+		}
+		else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+		{
+			cpu = atoi(argv[++i]);
+			if (cpu < 0)
+				usage = true;
+		}
+		else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+		{
+			i++;
+			if (strcmp(argv[i], "none") == 0)
+				run = schedule<NoProtocol>;
+			else if (strcmp(argv[i], "pi") == 0)
+				run = schedule<InheritancePolicy>;
+			else if (strcmp(argv[i], "pc") == 0)
+				run = schedule<CeilingPolicy>;
+			else if (strcmp(argv[i], "ipc") == 0)
+				run = schedule<ImmediateCeilingPolicy>;
+			else if (strcmp(argv[i], "srp") == 0)
+				run = schedule<SrpPolicy>;
+			else
+				usage = true;
+		}
+		else if (argv[i][0] != '-' && taskSetPath == NULL)
+			taskSetPath = argv[i];
+		else
+			usage = true;
+	}
 
-		// wait for the timer pulse to fire
-		timer->wait();
-		printf("\n\n timer tick: %d\n", cnt+1);
+	if (usage || taskSetPath == NULL)
+	{
+		printf("usage: %s [-v] [-n] [-c] [-s] [-d record|abort] [-t tracefile] [-p none|pi|pc|ipc|srp] [-w workers] [-a cpu] <taskset>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
 
-		cnt++;
+#ifndef COROUTINES_AVAILABLE
+	if (coroutines)
+	{
+		printf("Error: coroutine jobs (-c) need a C++20 build\n");
+		return EXIT_FAILURE;
+	}
+#endif
+
+	if (taskSet.load(taskSetPath) != 0)
+		return EXIT_FAILURE;
+
+	// derive resource ceilings from the task scripts (checks declared ones)
+	taskSet.computeCeilings();
+
+	// allocate per-thread state (thread ids are task ids)
+	int threadCount = taskSet.getMaxTaskId() + 1;
+	readyQueue = new ReadyQueue(threadCount);
+	taskCond = new pthread_cond_t[threadCount];
+	parked = new bool[threadCount];
+	jobActive = new bool[threadCount];
+	accounting = new Accounting(taskSet.getMaxTaskId());
+	for (int i = 0; i < threadCount; i++)
+	{
+		pthread_cond_init(&taskCond[i], NULL);
+		parked[i] = false;
+		jobActive[i] = false;
+	}
+
+	// start job threads before the first release (coroutines need none)
+	if (cpu != NO_CPU && WorkerPool::pin(cpu) != 0)
+		printf("Error: cannot pin to CPU %d\n", cpu);
+	if (workerCount < 0)
+		workerCount = (taskSet.getTaskCount() < DEFAULT_WORKERS) ? taskSet.getTaskCount() : DEFAULT_WORKERS;
+	workers = new WorkerPool(coroutines ? 0 : workerCount, cpu);
+#ifdef COROUTINES_AVAILABLE
+	coJobs = new std::coroutine_handle<>[threadCount];
+#endif
+
+	// schedule first releases
+	releaseEvents = new TimerEvent[taskSet.getTaskCount()];
+	deadlineEvents = new TimerEvent[threadCount];
+	for (int i = 0; i < taskSet.getTaskCount(); i++)
+	{
+		TimingWheel::init(&releaseEvents[i], EVENT_RELEASE, i);
+		TimingWheel::init(&deadlineEvents[taskSet.getTask(i)->id], EVENT_DEADLINE, i);
+		wheel.schedule(&releaseEvents[i], taskSet.getTask(i)->release);
+	}
+
+	// create and start periodic timer to generate pulses every tick (real time only),
+	// tickless mode arms it per dispatch instead
+	PulseTimer* timer = NULL;
+	if (!virtualTime)
+	{
+		timer = new PulseTimer(taskSet.getTimeUnit() / 1000000.0);
+		if (!tickless)
+			timer->start();
+	}
+
+	if (statistics)
+		Profile::start();
+	if (deadlockMode != DEADLOCK_OFF)
+		Deadlock::start();
+
+	// start draining trace events (timeline output)
+	if (Trace::start(tracePath) != 0)
+		return EXIT_FAILURE;
+
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+	run(timer, deadlockMode);
+
+	// write out remaining trace events
+	Trace::stop();
+
+	// per-task response and blocking times
+	accounting->print(stdout, &taskSet);
+
+	if (statistics)
+	{
+		Profile::stop();
+		Profile::dump(stdout);
+	}
+
+	if (deadlockMode != DEADLOCK_OFF)
+	{
+		Deadlock::stop();
+		Deadlock::dump(stdout);
 	}
 
 	// stop and destroy the timer
-	timer->stop();
-	delete timer;
+	if (timer != NULL)
+	{
+		timer->stop();
+		delete timer;
+	}
 }
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Trace.h"
+
+//-----------------------------------------------------------------------------------------
+// Offline trace decoder.
+// Reads a binary trace written by "inversion -t <file>" and prints the timeline in the
+// same human readable format as the live output (see doc/logs_*.txt).
+//
+// usage: tracedump <tracefile> [-r]   (-r adds sequence number and timestamp columns)
+//-----------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: %s <tracefile> [-r]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	bool raw = (argc > 2 && strcmp(argv[2], "-r") == 0);
+
+	FILE* input = fopen(argv[1], "rb");
+	if (input == NULL)
+	{
+		printf("Error opening trace file %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	TraceFileHeader header;
+	if (fread(&header, sizeof(header), 1, input) != 1
+			|| memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != TRACE_VERSION
+			|| header.eventSize != sizeof(TraceEvent))
+	{
+		printf("Error: %s is not a version %d trace file\n", argv[1], TRACE_VERSION);
+		fclose(input);
+		return EXIT_FAILURE;
+	}
+
+	TraceEvent event;
+	uint64_t start = 0;
+	char text[256];
+	while (fread(&event, sizeof(event), 1, input) == 1)
+	{
+		if (event.sequence == 0)
+			start = event.timestamp;
+
+		int length = Trace::format(event, text, sizeof(text));
+		if (raw)
+		{
+			// one event per line: strip the timeline's line breaks
+			char* line = text;
+			while (*line == '\n')
+				line++;
+			while (length > 0 && text[length - 1] == '\n')
+				text[--length] = '\0';
+
+			printf("[%8llu %12.3f us] %s\n", (unsigned long long) event.sequence,
+					(event.timestamp - start) / 1000.0, line);
+		}
+		else
+			fputs(text, stdout);
+	}
+
+	fclose(input);
+	return 0;
+}